@@ -0,0 +1,390 @@
+// BENCH SOURCE
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define SQLCHECK_HAVE_POSIX_SPAWN 1
+#endif
+
+#include "checker.h"
+#include "configuration.h"
+#include "json.h"
+#include "reader.h"
+#include "stats.h"
+
+#include "gflags/gflags.h"
+
+DEFINE_string(corpus, "", "Directory of .sql files to benchmark besides the generated inputs");
+DEFINE_string(startup_binary, "", "sqlcheck binary whose startup to benchmark");
+DEFINE_string(filter, "", "Only run the benchmarks whose name contains this");
+DEFINE_string(output, "", "Write the results to this JSON file");
+DEFINE_string(results, "", "Compare these stored results instead of running the benchmarks");
+DEFINE_string(baseline, "", "Compare the results with these baseline results");
+DEFINE_double(threshold, 0.05, "Relative slowdown of the median reported as a regression");
+DEFINE_uint64(repetitions, 10, "Timed runs of each benchmark");
+DEFINE_uint64(threads, 1, "Number of checker threads");
+DEFINE_bool(h, false, "Print help message");
+
+namespace sqlcheck {
+
+namespace {
+
+// Discards the output of the checker
+class NullBuffer : public std::streambuf {
+
+ protected:
+  int overflow(int c) override { return c; }
+
+  std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+
+};
+
+struct Benchmark {
+
+  std::string name;
+
+  // a timed run
+  std::function<void()> run;
+
+};
+
+struct BenchmarkResult {
+
+  std::string name;
+
+  // wall time of each run in nanoseconds
+  std::vector<double> samples;
+
+};
+
+// Check the input of a configuration, discarding the output
+void RunCheck(const std::function<void(Configuration&)>& configure){
+  static NullBuffer null_buffer;
+
+  Configuration state;
+  state.color_mode = false;
+  state.thread_count = FLAGS_threads;
+  configure(state);
+
+  auto cout_buffer = std::cout.rdbuf(&null_buffer);
+  Check(state);
+  std::cout.rdbuf(cout_buffer);
+}
+
+#ifdef SQLCHECK_HAVE_POSIX_SPAWN
+
+// Run the binary on a single statement, from exec to exit
+void RunStartup(const std::string& file_name){
+  posix_spawn_file_actions_t file_actions;
+  posix_spawn_file_actions_init(&file_actions);
+  posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+  std::vector<std::string> arguments = {FLAGS_startup_binary, "-q", "-f", file_name};
+  std::vector<char*> argv;
+  for (auto& argument : arguments) {
+    argv.push_back(&argument[0]);
+  }
+  argv.push_back(nullptr);
+
+  pid_t pid;
+  auto status = posix_spawn(&pid, FLAGS_startup_binary.c_str(), &file_actions,
+                            nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&file_actions);
+  if (status != 0) {
+    throw std::runtime_error("Could not run " + FLAGS_startup_binary);
+  }
+  waitpid(pid, &status, 0);
+}
+
+#endif
+
+// Many short statements, with and without anti-patterns
+std::string GenerateStatements(const size_t count){
+  std::ostringstream sql;
+  for (size_t i = 0; i < count; i++) {
+    switch (i % 5) {
+      case 0:
+        sql << "SELECT * FROM orders" << i << " WHERE id = " << i << ";\n";
+        break;
+      case 1:
+        sql << "CREATE TABLE t" << i << " (id INT PRIMARY KEY, cost FLOAT,\n"
+            << "  tags VARCHAR(255));\n";
+        break;
+      case 2:
+        sql << "SELECT a, b FROM t" << i << " JOIN u ON t" << i << ".id = u.id\n"
+            << "  WHERE name LIKE '%x%' ORDER BY RAND();\n";
+        break;
+      case 3:
+        sql << "INSERT INTO t" << i << " VALUES (" << i << ", 'a;b', NULL);\n";
+        break;
+      default:
+        sql << "UPDATE t" << i << " SET c = c || 'x' WHERE d IS NULL OR e > " << i << ";\n";
+        break;
+    }
+  }
+  return sql.str();
+}
+
+// Statements large enough to be checked one rule per task
+std::string GenerateLargeStatements(const size_t count){
+  std::ostringstream sql;
+  for (size_t i = 0; i < count; i++) {
+    sql << "SELECT id FROM t" << i << " WHERE id IN (";
+    for (size_t value = 0; value < 2000; value++) {
+      sql << (value ? ", " : "") << value * 7;
+    }
+    sql << ");\n";
+  }
+  return sql.str();
+}
+
+std::vector<Benchmark> GetBenchmarks(){
+  std::vector<Benchmark> benchmarks;
+
+  auto statements = GenerateStatements(1000);
+  benchmarks.push_back({"statements", [statements]() {
+    RunCheck([&](Configuration& state) {
+      state.testing_mode = true;
+      state.test_stream.reset(new std::istringstream(statements));
+    });
+  }});
+
+  auto large_statements = GenerateLargeStatements(20);
+  benchmarks.push_back({"large_statements", [large_statements]() {
+    RunCheck([&](Configuration& state) {
+      state.testing_mode = true;
+      state.test_stream.reset(new std::istringstream(large_statements));
+    });
+  }});
+
+  if (FLAGS_corpus.empty() == false) {
+    std::vector<std::string> file_names;
+    if (CollectInputFiles(FLAGS_corpus, file_names) == false || file_names.empty()) {
+      throw std::runtime_error("No SQL files found in corpus " + FLAGS_corpus);
+    }
+    benchmarks.push_back({"corpus", [file_names]() {
+      RunCheck([&](Configuration& state) {
+        state.file_names = file_names;
+      });
+    }});
+  }
+
+#ifdef SQLCHECK_HAVE_POSIX_SPAWN
+  // Startup latency of a pre-commit hook checking a single statement
+  if (FLAGS_startup_binary.empty() == false) {
+    auto file_name = (FLAGS_output.empty() ? std::string("bench") : FLAGS_output) +
+        ".startup.sql";
+    std::ofstream(file_name.c_str()) << "SELECT * FROM orders WHERE id = 1;\n";
+    benchmarks.push_back({"startup", [file_name]() {
+      RunStartup(file_name);
+    }});
+  }
+#endif
+
+  // Keep the benchmarks selected by the filter
+  std::vector<Benchmark> selected_benchmarks;
+  for (const auto& benchmark : benchmarks) {
+    if (benchmark.name.find(FLAGS_filter) != std::string::npos) {
+      selected_benchmarks.push_back(benchmark);
+    }
+  }
+
+  return selected_benchmarks;
+}
+
+std::vector<BenchmarkResult> RunBenchmarks(){
+  std::vector<BenchmarkResult> results;
+
+  for (const auto& benchmark : GetBenchmarks()) {
+    BenchmarkResult result;
+    result.name = benchmark.name;
+
+    // The first run warms up the caches and is not timed
+    for (size_t run = 0; run <= FLAGS_repetitions; run++) {
+      auto start = std::chrono::steady_clock::now();
+      benchmark.run();
+      auto end = std::chrono::steady_clock::now();
+
+      if (run > 0) {
+        result.samples.push_back(static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+      }
+    }
+
+    auto summary = SummarizeSamples(result.samples);
+    printf("%-20s :: median %10.3f ms  mad %8.3f ms  95%% ci [%.3f, %.3f] ms\n",
+           result.name.c_str(), summary.median / 1e6, summary.mad / 1e6,
+           summary.ci_low / 1e6, summary.ci_high / 1e6);
+    results.push_back(result);
+  }
+
+  return results;
+}
+
+void WriteResults(const std::string& file_name,
+                  const std::vector<BenchmarkResult>& results){
+  JsonValue document;
+  document.type = JSON_TYPE_OBJECT;
+  auto& benchmarks = document.object["benchmarks"];
+  benchmarks.type = JSON_TYPE_ARRAY;
+
+  for (const auto& result : results) {
+    auto summary = SummarizeSamples(result.samples);
+    JsonValue benchmark;
+    benchmark.type = JSON_TYPE_OBJECT;
+    benchmark.object["name"].type = JSON_TYPE_STRING;
+    benchmark.object["name"].string = result.name;
+    benchmark.object["unit"].type = JSON_TYPE_STRING;
+    benchmark.object["unit"].string = "ns";
+    benchmark.object["median"].type = JSON_TYPE_NUMBER;
+    benchmark.object["median"].number = summary.median;
+    benchmark.object["mad"].type = JSON_TYPE_NUMBER;
+    benchmark.object["mad"].number = summary.mad;
+
+    auto& samples = benchmark.object["samples"];
+    samples.type = JSON_TYPE_ARRAY;
+    for (auto sample : result.samples) {
+      JsonValue value;
+      value.type = JSON_TYPE_NUMBER;
+      value.number = sample;
+      samples.array.push_back(value);
+    }
+    benchmarks.array.push_back(benchmark);
+  }
+
+  std::ofstream output(file_name.c_str());
+  output << ToJson(document) << "\n";
+  if (output.good() == false) {
+    throw std::runtime_error("Could not write results " + file_name);
+  }
+}
+
+std::vector<BenchmarkResult> ReadResults(const std::string& file_name){
+  std::ifstream input(file_name.c_str());
+  if (input.is_open() == false) {
+    throw std::runtime_error("Could not read results " + file_name);
+  }
+  std::string text((std::istreambuf_iterator<char>(input)),
+                   std::istreambuf_iterator<char>());
+
+  JsonValue document;
+  if (ParseJson(text, document) == false ||
+      document.Get("benchmarks").type != JSON_TYPE_ARRAY) {
+    throw std::runtime_error("Invalid results " + file_name);
+  }
+
+  std::vector<BenchmarkResult> results;
+  for (const auto& benchmark : document.Get("benchmarks").array) {
+    BenchmarkResult result;
+    result.name = benchmark.Get("name").string;
+    for (const auto& sample : benchmark.Get("samples").array) {
+      result.samples.push_back(sample.number);
+    }
+    results.push_back(result);
+  }
+  return results;
+}
+
+// Print the change of each benchmark, returns false on a regression
+bool CompareResults(const std::vector<BenchmarkResult>& baseline,
+                    const std::vector<BenchmarkResult>& current){
+  bool regressed = false;
+
+  printf("\n%-20s    %12s %12s %9s\n", "BENCHMARK", "BASELINE ms", "CURRENT ms", "CHANGE");
+  for (const auto& result : current) {
+    const BenchmarkResult* baseline_result = nullptr;
+    for (const auto& candidate : baseline) {
+      if (candidate.name == result.name) {
+        baseline_result = &candidate;
+      }
+    }
+    if (baseline_result == nullptr) {
+      printf("%-20s :: NEW\n", result.name.c_str());
+      continue;
+    }
+
+    auto comparison = CompareSamples(baseline_result->samples, result.samples,
+                                     FLAGS_threshold);
+    printf("%-20s :: %12.3f %12.3f %+8.1f%% %s\n", result.name.c_str(),
+           comparison.baseline.median / 1e6, comparison.current.median / 1e6,
+           comparison.change * 100,
+           ComparisonResultToString(comparison.result).c_str());
+    regressed |= (comparison.result == COMPARISON_SLOWER);
+  }
+
+  return regressed == false;
+}
+
+}  // namespace
+
+}  // namespace sqlcheck
+
+void Usage() {
+  std::cout <<
+      "Command line options : sqlcheck_bench <options>\n"
+      "   -corpus                :  Directory of .sql files to benchmark as well \n"
+      "   -startup_binary        :  sqlcheck binary whose startup to benchmark \n"
+      "   -filter                :  Only run the benchmarks whose name contains this \n"
+      "   -repetitions           :  Timed runs of each benchmark (10 by default) \n"
+      "   -threads               :  Number of checker threads (1 by default) \n"
+      "   -output                :  Write the results to this JSON file \n"
+      "   -results               :  Compare these stored results instead of running \n"
+      "   -baseline              :  Compare with these results, failing on regressions \n"
+      "   -threshold             :  Relative slowdown reported as a regression (0.05) \n"
+      "   -h                     :  Print help message \n";
+}
+
+int main(int argc, char **argv) {
+
+  try {
+
+    gflags::SetUsageMessage("");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    if(FLAGS_h == true){
+      Usage();
+      gflags::ShutDownCommandLineFlags();
+      return (EXIT_SUCCESS);
+    }
+
+    std::vector<sqlcheck::BenchmarkResult> results;
+    if(FLAGS_results.empty() == false){
+      results = sqlcheck::ReadResults(FLAGS_results);
+    }
+    else{
+      results = sqlcheck::RunBenchmarks();
+    }
+
+    if(FLAGS_output.empty() == false){
+      sqlcheck::WriteResults(FLAGS_output, results);
+    }
+
+    if(FLAGS_baseline.empty() == false &&
+        sqlcheck::CompareResults(sqlcheck::ReadResults(FLAGS_baseline), results) == false){
+      std::cerr << "Benchmarks regressed beyond " << FLAGS_threshold * 100 << "%\n";
+      gflags::ShutDownCommandLineFlags();
+      return (EXIT_FAILURE);
+    }
+
+  }
+  catch (std::exception& exc) {
+    std::cerr << exc.what() << std::endl;
+    gflags::ShutDownCommandLineFlags();
+    exit(EXIT_FAILURE);
+  }
+
+  gflags::ShutDownCommandLineFlags();
+  return (EXIT_SUCCESS);
+}
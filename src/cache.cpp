@@ -0,0 +1,184 @@
+// CACHE SOURCE
+
+#include <functional>
+
+#include "include/cache.h"
+#include "include/counters.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Bytes of an index node and its bucket, beyond the entry
+const size_t kIndexEntrySize = 64;
+
+// FNV-1a, independent of the standard hash
+std::uint64_t HashFnv(const std::string& text){
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (auto c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+StatementFingerprint GetStatementFingerprint(const std::string& statement,
+                                             const LineShifts& line_shifts){
+  StatementFingerprint fingerprint;
+  fingerprint.high = HashFnv(statement);
+  fingerprint.low = std::hash<std::string>()(statement);
+  fingerprint.length = statement.size();
+
+  for (const auto& line_shift : line_shifts) {
+    auto shift = (static_cast<std::uint64_t>(line_shift.offset) << 32) ^ line_shift.lines;
+    fingerprint.high = (fingerprint.high ^ shift) * 1099511628211ULL;
+    fingerprint.low = (fingerprint.low ^ shift) * 0x9e3779b97f4a7c15ULL;
+  }
+  return fingerprint;
+}
+
+FindingCache::FindingCache(const size_t capacity)
+ : shard_capacity_(capacity / kShardCount) {
+}
+
+bool FindingCache::Find(const StatementFingerprint& fingerprint,
+                        std::vector<Finding>& findings){
+  if (shard_capacity_ == 0) {
+    return false;
+  }
+
+  auto& counters = GetThreadCounters();
+  std::shared_ptr<const std::vector<CachedFinding>> entry_findings;
+  {
+    auto& shard = GetShard(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto slot = shard.index.find(fingerprint);
+    if (slot == shard.index.end()) {
+      IncrementCounter(counters.cache_misses);
+      return false;
+    }
+    auto& entry = shard.entries[slot->second];
+    entry.referenced = true;
+    entry_findings = entry.findings;
+  }
+
+  IncrementCounter(counters.cache_hits);
+  findings.resize(entry_findings->size());
+  for (size_t i = 0; i < findings.size(); i++) {
+    const auto& cached_finding = (*entry_findings)[i];
+    auto& finding = findings[i];
+    finding.rule = cached_finding.rule;
+    finding.risk_level = cached_finding.risk_level;
+    finding.pattern_type = cached_finding.pattern_type;
+    finding.title = *cached_finding.title;
+    finding.message = *cached_finding.message;
+    finding.exists = cached_finding.exists;
+    finding.match = cached_finding.match;
+    finding.lines = cached_finding.lines;
+  }
+  return true;
+}
+
+void FindingCache::Insert(const StatementFingerprint& fingerprint,
+                          const std::vector<Finding>& findings){
+  if (shard_capacity_ == 0) {
+    return;
+  }
+
+  std::shared_ptr<std::vector<CachedFinding>> cached_findings(
+      new std::vector<CachedFinding>(findings.size()));
+  size_t size = sizeof(Entry) + kIndexEntrySize +
+      sizeof(std::vector<CachedFinding>) + findings.size() * sizeof(CachedFinding);
+  for (size_t i = 0; i < findings.size(); i++) {
+    const auto& finding = findings[i];
+    auto& cached_finding = (*cached_findings)[i];
+    cached_finding.rule = finding.rule;
+    cached_finding.risk_level = finding.risk_level;
+    cached_finding.pattern_type = finding.pattern_type;
+    cached_finding.title = GetText(finding.title);
+    cached_finding.message = GetText(finding.message);
+    cached_finding.exists = finding.exists;
+    cached_finding.match = finding.match;
+    cached_finding.lines = finding.lines;
+    size += cached_finding.match.capacity() +
+        cached_finding.lines.capacity() * sizeof(std::uint32_t);
+  }
+
+  Entry entry;
+  entry.fingerprint = fingerprint;
+  entry.findings = std::move(cached_findings);
+  entry.size = size;
+  entry.referenced = false;
+  if (entry.size > shard_capacity_) {
+    return;
+  }
+
+  auto& shard = GetShard(fingerprint);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  // Another thread checked the same statement
+  if (shard.index.count(fingerprint) != 0) {
+    return;
+  }
+
+  Evict(shard, entry.size);
+
+  size_t slot;
+  if (shard.free_slots.empty() == false) {
+    slot = shard.free_slots.back();
+    shard.free_slots.pop_back();
+  }
+  else {
+    slot = shard.entries.size();
+    shard.entries.emplace_back();
+  }
+
+  shard.size += entry.size;
+  shard.index.emplace(fingerprint, slot);
+  shard.entries[slot] = std::move(entry);
+}
+
+void FindingCache::Evict(Shard& shard, const size_t size){
+  auto& counters = GetThreadCounters();
+
+  // Entries found since the last sweep get a second chance
+  while (shard.size + size > shard_capacity_) {
+    if (shard.hand >= shard.entries.size()) {
+      shard.hand = 0;
+    }
+    auto& entry = shard.entries[shard.hand];
+
+    if (entry.findings != nullptr) {
+      if (entry.referenced == true) {
+        entry.referenced = false;
+      }
+      else {
+        shard.size -= entry.size;
+        shard.index.erase(entry.fingerprint);
+        entry.findings.reset();
+        shard.free_slots.push_back(shard.hand);
+        IncrementCounter(counters.cache_evictions);
+      }
+    }
+
+    shard.hand++;
+  }
+}
+
+const std::string* FindingCache::GetText(const std::string& text){
+  std::lock_guard<std::mutex> lock(texts_mutex_);
+  return &*texts_.insert(text).first;
+}
+
+size_t FindingCache::GetSize(){
+  size_t size = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size += shard.size;
+  }
+  return size;
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,278 @@
+// CHANGES SOURCE
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "include/changes.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Strip the "a/" or "b/" prefix git adds and the timestamp some diff tools add
+std::string GetDiffPath(const std::string& line){
+
+  auto path = line.substr(4);
+  auto tab = path.find('\t');
+  if (tab != std::string::npos) {
+    path = path.substr(0, tab);
+  }
+  if (path.compare(0, 2, "a/") == 0 || path.compare(0, 2, "b/") == 0) {
+    path = path.substr(2);
+  }
+
+  return path;
+}
+
+std::string StripDotSlash(const std::string& path){
+  if (path.compare(0, 2, "./") == 0) {
+    return path.substr(2);
+  }
+  return path;
+}
+
+bool EndsWithPath(const std::string& path, const std::string& suffix){
+  if (suffix.size() > path.size()) {
+    return false;
+  }
+  if (path.compare(path.size() - suffix.size(), suffix.size(), suffix) != 0) {
+    return false;
+  }
+  return suffix.size() == path.size() || path[path.size() - suffix.size() - 1] == '/';
+}
+
+// Diff paths are relative to the repository root whereas the checked file
+// may be given relative to the working directory, so match on path suffix
+bool IsSameFile(const std::string& diff_path, const std::string& file_name){
+
+  if (file_name.empty()) {
+    return true;
+  }
+
+  auto lhs = StripDotSlash(diff_path);
+  auto rhs = StripDotSlash(file_name);
+  return EndsWithPath(lhs, rhs) || EndsWithPath(rhs, lhs);
+}
+
+// Parse "@@ -a,b +c,d @@" into the first new line and the hunk lengths
+bool ParseHunkHeader(const std::string& line,
+                     std::uint32_t& new_line,
+                     std::uint32_t& old_count,
+                     std::uint32_t& new_count){
+
+  const char* cursor = line.c_str() + 2;
+  while (*cursor == ' ') {
+    cursor++;
+  }
+  if (*cursor != '-') {
+    return false;
+  }
+
+  char* end = nullptr;
+  std::strtoul(cursor + 1, &end, 10);
+  old_count = 1;
+  if (*end == ',') {
+    old_count = static_cast<std::uint32_t>(std::strtoul(end + 1, &end, 10));
+  }
+
+  while (*end == ' ') {
+    end++;
+  }
+  if (*end != '+') {
+    return false;
+  }
+
+  new_line = static_cast<std::uint32_t>(std::strtoul(end + 1, &end, 10));
+  new_count = 1;
+  if (*end == ',') {
+    new_count = static_cast<std::uint32_t>(std::strtoul(end + 1, &end, 10));
+  }
+
+  return true;
+}
+
+}  // namespace
+
+void NormalizeLineRanges(LineRanges& ranges){
+
+  if (ranges.empty()) {
+    return;
+  }
+
+  std::sort(ranges.begin(), ranges.end());
+
+  LineRanges merged;
+  merged.push_back(ranges.front());
+  for (size_t i = 1; i < ranges.size(); i++) {
+    auto& last = merged.back();
+    if (ranges[i].first <= last.second + 1) {
+      last.second = std::max(last.second, ranges[i].second);
+    }
+    else {
+      merged.push_back(ranges[i]);
+    }
+  }
+
+  ranges.swap(merged);
+}
+
+bool OverlapsLineRanges(const LineRanges& ranges,
+                        const std::uint32_t first_line,
+                        const std::uint32_t last_line){
+
+  // first range that ends at or after the first line of the span
+  auto it = std::lower_bound(ranges.begin(), ranges.end(), first_line,
+                             [](const std::pair<std::uint32_t, std::uint32_t>& range,
+                                const std::uint32_t line) {
+                               return range.second < line;
+                             });
+
+  return it != ranges.end() && it->first <= last_line;
+}
+
+void ParseUnifiedDiff(std::istream& diff,
+                      const std::string& file_name,
+                      LineRanges& ranges){
+
+  std::string line;
+  bool in_file = false;
+  std::uint32_t new_line = 0;
+  std::uint32_t old_count = 0;
+  std::uint32_t new_count = 0;
+
+  while (std::getline(diff, line)) {
+
+    // Outside a hunk: file headers and hunk headers
+    if (old_count == 0 && new_count == 0) {
+      if (line.compare(0, 4, "+++ ") == 0) {
+        in_file = IsSameFile(GetDiffPath(line), file_name);
+      }
+      else if (line.compare(0, 2, "@@") == 0) {
+        if (ParseHunkHeader(line, new_line, old_count, new_count) == false) {
+          old_count = new_count = 0;
+        }
+      }
+      continue;
+    }
+
+    // Inside a hunk: the header tells how many lines are left
+    if (line.empty() || line[0] == ' ') {
+      new_line++;
+      old_count -= (old_count > 0);
+      new_count -= (new_count > 0);
+    }
+    else if (line[0] == '+') {
+      if (in_file) {
+        ranges.push_back(std::make_pair(new_line, new_line));
+      }
+      new_line++;
+      new_count -= (new_count > 0);
+    }
+    else if (line[0] == '-') {
+      // A removed line changes the statement on either side of it
+      if (in_file) {
+        ranges.push_back(std::make_pair(std::max<std::uint32_t>(new_line, 2) - 1,
+                                        new_line));
+      }
+      old_count -= (old_count > 0);
+    }
+  }
+
+  NormalizeLineRanges(ranges);
+}
+
+bool ParseLineRanges(const std::string& spec,
+                     LineRanges& ranges){
+
+  std::stringstream entries(spec);
+  std::string entry;
+
+  while (std::getline(entries, entry, ',')) {
+
+    if (entry.empty()) {
+      continue;
+    }
+
+    char* end = nullptr;
+    auto first = std::strtoul(entry.c_str(), &end, 10);
+    auto last = first;
+    if (end == entry.c_str() || first == 0) {
+      return false;
+    }
+
+    if (*end == '-') {
+      auto last_begin = end + 1;
+      last = std::strtoul(last_begin, &end, 10);
+      if (end == last_begin || last < first) {
+        return false;
+      }
+    }
+
+    if (*end != '\0') {
+      return false;
+    }
+
+    ranges.push_back(std::make_pair(static_cast<std::uint32_t>(first),
+                                    static_cast<std::uint32_t>(last)));
+  }
+
+  NormalizeLineRanges(ranges);
+  return true;
+}
+
+bool ParseChangedLines(const std::string& spec,
+                       const std::string& file_name,
+                       LineRanges& ranges){
+
+  // Unified diff file
+  std::ifstream diff(spec.c_str());
+  if (diff.good()) {
+    ParseUnifiedDiff(diff, file_name, ranges);
+    return true;
+  }
+
+  // Whitespace-separated list of [file:]ranges entries
+  std::stringstream entries(spec);
+  std::string entry;
+
+  while (entries >> entry) {
+    auto colon = entry.rfind(':');
+    if (colon == std::string::npos) {
+      if (ParseLineRanges(entry, ranges) == false) {
+        return false;
+      }
+      continue;
+    }
+
+    LineRanges file_ranges;
+    if (ParseLineRanges(entry.substr(colon + 1), file_ranges) == false) {
+      return false;
+    }
+    if (IsSameFile(entry.substr(0, colon), file_name)) {
+      ranges.insert(ranges.end(), file_ranges.begin(), file_ranges.end());
+    }
+  }
+
+  NormalizeLineRanges(ranges);
+  return true;
+}
+
+std::string LineRangesToString(const LineRanges& ranges){
+
+  std::stringstream str;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (i > 0) {
+      str << ",";
+    }
+    str << ranges[i].first;
+    if (ranges[i].second != ranges[i].first) {
+      str << "-" << ranges[i].second;
+    }
+  }
+
+  return str.str();
+}
+
+}  // namespace sqlcheck
@@ -11,193 +11,393 @@
 #include <functional>
 #include <regex>
 #include <map>
+#include <algorithm>
+#include <iomanip>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 
 #include "include/checker.h"
 
 #include "include/configuration.h"
+#include "include/counters.h"
 #include "include/list.h"
 #include "include/color.h"
+#include "include/pipeline.h"
+#include "include/perf_counters.h"
+#include "include/trace.h"
 
 namespace sqlcheck {
 
-bool Check(Configuration& state) {
+namespace {
 
-  bool has_issues = false;
-  std::unique_ptr<std::istream> input;
+// Starts a paragraph of a message
+const char kParagraphMark[] = "●";
+
+// White space between words (as in the classic locale)
+bool IsWrapSpace(const char c){
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-  // Set up stream
-  if(state.testing_mode == true){
-    input.reset(state.test_stream.release());
+// Print the counts per statement and the counts of each rule, most
+// expensive rule first
+void PrintPerfCounters(const Configuration& state,
+                       const std::vector<PerfCounts>& slot_counts,
+                       const bool available[PERF_COUNTER_COUNT]){
+
+  const auto& rules = GetRules();
+  const auto& statement_counts = slot_counts[GetStatementCounterSlot()];
+  auto statement_count = std::max<std::uint64_t>(statement_counts.sample_count, 1);
+
+  std::cout << "\n=============== Performance Counters ===============\n";
+  std::cout << "Statements :: " << statement_counts.sample_count << "\n";
+
+  // Hits depend on the order of the threads, so they are left out of the
+  // summary
+  std::cout << "Finding Cache :: " << state.checker_stats.cache_hits << " hits, "
+      << state.checker_stats.cache_misses << " misses, "
+      << state.checker_stats.cache_evictions << " evictions\n";
+
+  std::string unavailable;
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (available[i] == false) {
+      unavailable += (unavailable.empty() ? "" : ", ") +
+          PerfCounterToString(static_cast<PerfCounter>(i));
+    }
   }
-  else if (state.file_name.empty()) {
-    input.reset(&std::cin);
+  if (unavailable.empty() == false) {
+    std::cout << "Unavailable :: " << unavailable << "\n";
   }
-  else {
-    //std::cout << "Checking " << state.file_name << "...\n";
-    input.reset(new std::ifstream(state.file_name.c_str()));
+
+  std::cout << std::left << std::setw(28) << "" << std::right;
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (available[i] == true) {
+      std::cout << std::setw(18) << PerfCounterToString(static_cast<PerfCounter>(i));
+    }
+  }
+  std::cout << "\n";
+
+  auto print_row = [&](const std::string& name, const PerfCounts& counts,
+                       const std::uint64_t divisor){
+    std::cout << std::left << std::setw(28) << name << std::right;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+      if (available[i] == true) {
+        std::cout << std::setw(18) << counts.values[i] / divisor;
+      }
+    }
+    std::cout << "\n";
+  };
+
+  print_row("Per Statement", statement_counts, statement_count);
+  print_row("All Statements", statement_counts, 1);
+
+  // Rank the rules by cycles, or by time without hardware counters
+  auto rank_counter = available[PERF_COUNTER_CYCLES] ?
+      PERF_COUNTER_CYCLES : PERF_COUNTER_TASK_CLOCK;
+  std::vector<size_t> rule_order(rules.size());
+  for (size_t rule = 0; rule < rules.size(); rule++) {
+    rule_order[rule] = rule;
   }
+  std::stable_sort(rule_order.begin(), rule_order.end(), [&](size_t a, size_t b){
+    return slot_counts[a].values[rank_counter] > slot_counts[b].values[rank_counter];
+  });
 
-  std::stringstream sql_statement;
-  state.line_number = 1;
+  std::cout << "Per Rule (all statements)\n";
+  for (auto rule : rule_order) {
+    print_row(std::string("> ") + rules[rule].name, slot_counts[rule], 1);
+  }
 
-  std::cout << "==================== Results ===================\n";
+}
+
+// Print the findings of each pattern type, of each rule (most frequent
+// first) and of each file, leaving out those without findings
+void PrintSummaryBreakdown(const Configuration& state){
 
-  // Go over the input stream
-  while(!input->eof()){
+  const auto& stats = state.checker_stats;
+  const auto& rules = GetRules();
 
-    // Get a statement from the input stream
-    std::string statement_fragment;
-    std::getline(*input, statement_fragment, state.delimiter[0]);
+  std::cout << "\nBy Pattern Type\n";
+  for (size_t type = 0; type < kPatternTypeCount; type++) {
+    if (stats.total.pattern_types[type] != 0) {
+      std::cout << ">  " << std::left << std::setw(40)
+          << PatternTypeToString(static_cast<PatternType>(type))
+          << std::right << ":: " << stats.total.pattern_types[type] << "\n";
+    }
+  }
+
+  std::vector<size_t> rule_order;
+  for (size_t rule = 0; rule < rules.size(); rule++) {
+    if (stats.total.rules[rule] != 0) {
+      rule_order.push_back(rule);
+    }
+  }
+  std::stable_sort(rule_order.begin(), rule_order.end(), [&](size_t a, size_t b){
+    return stats.total.rules[a] > stats.total.rules[b];
+  });
+
+  std::cout << "\nBy Rule\n";
+  for (auto rule : rule_order) {
+    std::cout << ">  " << std::left << std::setw(40) << rules[rule].name
+        << std::right << ":: " << stats.total.rules[rule] << "\n";
+  }
 
-    // Append fragment to statement
-    if(statement_fragment.empty() == false){
-      sql_statement << statement_fragment << " ";
+  if (stats.files.empty() == false) {
+    std::cout << "\nBy File\n";
+    for (size_t file = 0; file < stats.files.size(); file++) {
+      const auto& counts = stats.files[file].risk_levels;
+      if (counts[RISK_LEVEL_ALL] == 0) {
+        continue;
+      }
+      std::cout << ">  " << state.file_names[file] << " :: " << counts[RISK_LEVEL_ALL]
+          << " (" << counts[RISK_LEVEL_HIGH] << " high, "
+          << counts[RISK_LEVEL_MEDIUM] << " medium, "
+          << counts[RISK_LEVEL_LOW] << " low, "
+          << counts[RISK_LEVEL_NONE] << " hints)\n";
     }
+  }
+
+}
+
+}  // namespace
+
+size_t GetStatementCounterSlot(){
+  return GetRules().size();
+}
+
+bool Check(Configuration& state) {
+
+  bool has_issues = false;
+  state.line_number = 1;
+  state.checker_stats.Reset(state.file_names.size());
+  ResetCounters();
+  GetInterner().Clear();
 
-    // Check the statement
-    CheckStatement(state, sql_statement.str());
+  std::cout << "==================== Results ===================\n";
 
-    // Reset statement
-    sql_statement.str(std::string());
+  // Read, split, check and print the statements
+  if(state.trace_file.empty() == false){
+    StartTrace();
+  }
+  if(state.perf_counters_mode == true){
+    std::string error;
+    if(StartPerfCounters(GetStatementCounterSlot() + 1, error) == false){
+      std::cerr << "Performance counters unavailable: " << error << "\n";
+    }
+  }
+  RunPipeline(state, std::cout);
+
+  auto counters = ReadCounters();
+  state.checker_stats.statements = counters.statements;
+  state.checker_stats.bytes = counters.bytes;
+  state.checker_stats.total = counters.findings;
+  state.checker_stats.cache_hits = counters.cache_hits;
+  state.checker_stats.cache_misses = counters.cache_misses;
+  state.checker_stats.cache_evictions = counters.cache_evictions;
+  if(state.trace_file.empty() == false &&
+      WriteTrace(state.trace_file) == false){
+    std::cerr << "Could not write trace file " << state.trace_file << "\n";
   }
 
   // Print summary
-  if(state.checker_stats[RISK_LEVEL_ALL] == 0){
+  const auto& risk_levels = state.checker_stats.total.risk_levels;
+  if(risk_levels[RISK_LEVEL_ALL] == 0){
     std::cout << "No issues found.\n";
   }
   else {
     std::cout << "\n==================== Summary ===================\n";
-    std::cout << "All Anti-Patterns and Hints  :: " << state.checker_stats[RISK_LEVEL_ALL] << "\n";
-    std::cout << ">  High Risk   :: " << state.checker_stats[RISK_LEVEL_HIGH] << "\n";
-    std::cout << ">  Medium Risk :: " << state.checker_stats[RISK_LEVEL_MEDIUM] << "\n";
-    std::cout << ">  Low Risk    :: " << state.checker_stats[RISK_LEVEL_LOW] << "\n";
-    std::cout << ">  Hints       :: " << state.checker_stats[RISK_LEVEL_NONE] << "\n";
+    std::cout << "Statements Checked           :: " << state.checker_stats.statements
+        << " (" << state.checker_stats.bytes << " bytes)\n";
+    std::cout << "All Anti-Patterns and Hints  :: " << risk_levels[RISK_LEVEL_ALL] << "\n";
+    std::cout << ">  High Risk   :: " << risk_levels[RISK_LEVEL_HIGH] << "\n";
+    std::cout << ">  Medium Risk :: " << risk_levels[RISK_LEVEL_MEDIUM] << "\n";
+    std::cout << ">  Low Risk    :: " << risk_levels[RISK_LEVEL_LOW] << "\n";
+    std::cout << ">  Hints       :: " << risk_levels[RISK_LEVEL_NONE] << "\n";
+    PrintSummaryBreakdown(state);
     has_issues = true;
   }
 
-  // Skip destroying std::cin
-  if (state.file_name.empty()) {
-    input.release();
+  if(perf_counters_enabled == true){
+    std::vector<PerfCounts> slot_counts;
+    bool available[PERF_COUNTER_COUNT];
+    StopPerfCounters(slot_counts, available);
+    PrintPerfCounters(state, slot_counts, available);
   }
 
   return has_issues;
 
 }
 
-// Wrap the text
-std::string WrapText(const std::string& text){
+// Write the text wrapped at line_length, in a single pass over its words
+// (verbatim if line_length is 0)
+void WriteWrappedText(std::ostream& output,
+                      const std::string& text,
+                      const size_t line_length){
 
-  size_t line_length = 80;
+  if (line_length == 0) {
+    output.write(text.data(), text.size());
+    return;
+  }
 
-  std::istringstream words(text);
-  std::ostringstream wrapped;
-  std::string word;
+  auto position = text.data();
+  auto end = position + text.size();
+  size_t space_left = 0;
+  bool first_word = true;
   bool newline = false;
-  bool newpara = false;
 
-  if (words >> word) {
+  while (true) {
+    while (position != end && IsWrapSpace(*position)) {
+      position++;
+    }
+    if (position == end) {
+      break;
+    }
 
-    wrapped << word;
+    auto word = position;
+    while (position != end && IsWrapSpace(*position) == false) {
+      position++;
+    }
+    size_t word_length = position - word;
 
-    size_t space_left = line_length - word.length();
-    while (words >> word) {
-      if(word == "●"){
-        wrapped << "\n\n";
-        newpara = true;
-      }
-      else{
-        newpara = false;
-      }
+    if (first_word == true) {
+      output.write(word, word_length);
+      space_left = (word_length >= line_length) ? 0 : line_length - word_length;
+      first_word = false;
+      continue;
+    }
 
-      if (space_left < word.length() + 1 || newline) {
-        wrapped << '\n' << word;
-        space_left = line_length - word.length();
-      }
-      else {
-        if(newpara == false){
-          wrapped << ' ' << word;
-        }
-        else{
-          wrapped << word;
-        }
-        space_left -= word.length() + 1;
-      }
+    // A bullet starts a paragraph
+    bool newpara = (word_length == sizeof(kParagraphMark) - 1 &&
+        memcmp(word, kParagraphMark, word_length) == 0);
+    if(newpara == true){
+      output.write("\n\n", 2);
+    }
 
-      if(word.back() == ':'){
-        newline = true;
-      }
-      else{
-        newline = false;
+    if (space_left < word_length + 1 || newline) {
+      output.put('\n');
+      output.write(word, word_length);
+      space_left = (word_length >= line_length) ? 0 : line_length - word_length;
+    }
+    else {
+      if(newpara == false){
+        output.put(' ');
       }
+      output.write(word, word_length);
+      space_left -= word_length + 1;
     }
 
+    // A heading ends its line
+    newline = (word[word_length - 1] == ':');
   }
 
+}
+
+std::string WrapText(const std::string& text, const size_t line_length){
+  std::ostringstream wrapped;
+  WriteWrappedText(wrapped, text, line_length);
   return wrapped.str();
 }
 
+// Messages are the same for every finding of a rule, so each thread wraps
+// each of them once (in paragraphs without wrapping lines if line_length
+// is 0)
+const std::string& GetWrappedMessage(const std::string& message,
+                                     const size_t line_length){
+  static thread_local size_t wrapped_line_length = 0;
+  static thread_local std::unordered_map<std::string, std::string> wrapped_messages;
+
+  if (line_length != wrapped_line_length) {
+    wrapped_messages.clear();
+    wrapped_line_length = line_length;
+  }
+
+  auto wrapped_message = wrapped_messages.find(message);
+  if (wrapped_message == wrapped_messages.end()) {
+    auto wrapped = WrapText(message, line_length ? line_length : SIZE_MAX);
+    wrapped_message = wrapped_messages.emplace(message, wrapped).first;
+  }
+  return wrapped_message->second;
+}
+
+void PrintStatement(Configuration& state,
+                    std::ostream& output,
+                    const std::string& sql_statement,
+                    const std::vector<std::uint32_t>& lines){
+
+  output << "\n-------------------------------------------------\n";
+  output << "SQL Statement at line" << (lines.size() > 1 ? "s " : " ");
+  for (size_t i = 0; i < lines.size(); i++) {
+    output << (i > 0 ? ", " : "") << lines[i];
+  }
+  if (lines.size() > 1) {
+    output << " (" << lines.size() << " occurrences)";
+  }
+  output << ": ";
+
+  ColorModifier red(ColorCode::FG_RED, state.color_mode, true);
+  ColorModifier regular(ColorCode::FG_DEFAULT, state.color_mode, false);
+  if(state.color_mode == true){
+    output << red;
+    WriteWrappedText(output, sql_statement, state.line_width);
+    output << state.delimiter << regular << "\n";
+  }
+  else {
+    WriteWrappedText(output, sql_statement, state.line_width);
+    output << state.delimiter << "\n";
+  }
+
+}
+
 void PrintMessage(Configuration& state,
-                  const std::string sql_statement,
+                  std::ostream& output,
+                  const std::string& sql_statement,
                   const bool print_statement,
                   const RiskLevel pattern_risk_level,
                   const PatternType pattern_type,
-                  const std::string title,
-                  const std::string message){
+                  const std::string& title,
+                  const std::string& message){
 
-  ColorModifier red(ColorCode::FG_RED, state.color_mode, true);
   ColorModifier green(ColorCode::FG_GREEN, state.color_mode, true);
   ColorModifier blue(ColorCode::FG_BLUE, state.color_mode, true);
   ColorModifier regular(ColorCode::FG_DEFAULT, state.color_mode, false);
 
   if(print_statement == true){
-    std::cout << "\n-------------------------------------------------\n";
-    ColorModifier regular(ColorCode::FG_DEFAULT, state.color_mode, false);
-
-    if(state.color_mode == true){
-      std::cout << "SQL Statement at line " << state.line_number <<": " << red << WrapText(sql_statement) << state.delimiter << regular << "\n";
-    }
-    else {
-      std::cout << "SQL Statement at line " << state.line_number << ": " << WrapText(sql_statement) << state.delimiter << "\n";
-    }
+    PrintStatement(state, output, sql_statement,
+                   std::vector<std::uint32_t>(1, state.line_number));
   }
 
   if(state.color_mode == true){
     if(state.file_name.empty() == false){
-      std::cout << "[" << state.file_name << "]: ";
+      output << "[" << state.file_name << "]: ";
     }
 
-    std::cout << "(" << green << RiskLevelToString(pattern_risk_level) << regular << ") ";
-    std::cout << blue << title << regular << "\n";
+    output << "(" << green << RiskLevelToString(pattern_risk_level) << regular << ") ";
+    output << blue << title << regular << "\n";
   }
   else {
     if(state.file_name.empty() == false){
-      std::cout << "[" << state.file_name << "]: ";
+      output << "[" << state.file_name << "]: ";
     }
 
-    std::cout << "(" << RiskLevelToString(pattern_risk_level) << ") ";
-    std::cout << "(" << PatternTypeToString(pattern_type) << ") ";
-    std::cout << title << "\n";
+    output << "(" << RiskLevelToString(pattern_risk_level) << ") ";
+    output << "(" << PatternTypeToString(pattern_type) << ") ";
+    output << title << "\n";
   }
 
   // Print detailed message only in verbose mode
   if(state.verbose == true){
-    std::cout << WrapText(message) << "\n";
+    output << GetWrappedMessage(message, state.line_width) << "\n";
   }
 
-  // Update checker stats
-  state.checker_stats[pattern_risk_level]++;
-  state.checker_stats[RISK_LEVEL_ALL]++;
-
 }
 
 void CheckPattern(Configuration& state,
                   const std::string& sql_statement,
                   bool& print_statement,
-                  const std::regex& anti_pattern,
+                  const Matcher& anti_pattern,
                   const RiskLevel pattern_risk_level,
                   const PatternType pattern_type,
-                  const std::string title,
-                  const std::string message,
+                  const std::string& title,
+                  const std::string& message,
                   const bool exists,
                   const size_t min_count){
 
@@ -209,6 +409,12 @@ void CheckPattern(Configuration& state,
     return;
   }
 
+  // Most statements have no match, the generated state machine of the
+  // pattern tells them apart without running the regex
+  if (anti_pattern.MayMatch(sql_statement, state.pattern_matches) == false) {
+    return;
+  }
+
   bool found = false;
   std::smatch match;
   std::size_t count = 0;
@@ -216,7 +422,8 @@ void CheckPattern(Configuration& state,
   // create an vector for the match positions
   std::vector<size_t> positions;
   try {
-    std::sregex_iterator sqlsearch = std::sregex_iterator(sql_statement.begin(), sql_statement.end(), anti_pattern);
+    const std::regex& regex = anti_pattern.GetRegex();
+    std::sregex_iterator sqlsearch = std::sregex_iterator(sql_statement.begin(), sql_statement.end(), regex);
     std::sregex_iterator sqlend = std::sregex_iterator();
     count = std::distance(sqlsearch, sqlend);
     if (count > 0) {
@@ -224,82 +431,127 @@ void CheckPattern(Configuration& state,
     }
 
     if(found == exists && count > min_count){
+
+      Finding finding;
+      finding.rule = state.rule_index;
+      finding.risk_level = pattern_risk_level;
+      finding.pattern_type = pattern_type;
+      finding.title = title;
+      finding.message = message;
+      finding.exists = exists;
+
       for (std::sregex_iterator next = sqlsearch; next != sqlend; ++next)
       {
           match = *next;
           // add match position to the vector
           positions.push_back(match.position(0));
       }
-
-      // update positions from character number to line number
-      uint32_t position_checker = 0;
-      uint32_t num_lines = state.line_number;
-      if (positions.size() > 0) {
-        for (size_t statement_char = 0; statement_char < sql_statement.length(); statement_char++) {
-          if (positions[position_checker] == statement_char) {
-            positions[position_checker] = num_lines;
-            position_checker++;
-          }
-          if (sql_statement[statement_char] == '\n') {
-            num_lines++;
-          }
+      finding.match = match.str(0);
+
+      // convert positions from character number to line number
+      // relative to the first line of the statement
+      size_t position_checker = 0;
+      uint32_t num_lines = 0;
+      for (size_t statement_char = 0;
+          statement_char < sql_statement.length() && position_checker < positions.size();
+          statement_char++) {
+        while (position_checker < positions.size() &&
+            positions[position_checker] == statement_char) {
+          finding.lines.push_back(num_lines +
+                                  GetRemovedLines(state.line_shifts, positions[position_checker]));
+          position_checker++;
+        }
+        if (sql_statement[statement_char] == '\n') {
+          num_lines++;
         }
       }
 
+      state.findings.push_back(finding);
+
+      // TOGGLE PRINT STATEMENT
+      print_statement = false;
+    }
+  } catch (std::regex_error& e) {
+    // Syntax error in the regular expression
+  }
+}
+
+void PrintFindings(Configuration& state,
+                   const std::string& sql_statement,
+                   std::ostream& output,
+                   bool print_statement){
+
+  TraceSpan span("print findings");
+
+  for (const auto& finding : state.findings) {
+
+    CountFinding(finding);
+    state.checker_stats.CountFile(finding, state.file_index);
+
+    PrintMessage(state,
+                 output,
+                 sql_statement,
+                 print_statement,
+                 finding.risk_level,
+                 finding.pattern_type,
+                 finding.title,
+                 finding.message);
+
+    if(finding.exists == true){
       std::stringstream linelocations;
       // convert line numbers to output string
-      if (positions.size() > 1) {
+      if (finding.lines.size() > 1) {
         linelocations << " at lines ";
       } else {
         linelocations << " at line ";
       }
-      for (size_t i = 0; i < positions.size(); i++) {
-          linelocations << positions[i];
-          if (i < positions.size() - 1) {
+      for (size_t i = 0; i < finding.lines.size(); i++) {
+          linelocations << state.line_number + finding.lines[i];
+          if (i < finding.lines.size() - 1) {
               linelocations << ", ";
           }
       }
-      PrintMessage(state,
-                  sql_statement,
-                  print_statement,
-                  pattern_risk_level,
-                  pattern_type,
-                  title,
-                  message);
-
-      if(exists == true){
-        ColorModifier blue(ColorCode::FG_BLUE, state.color_mode, true);
-        ColorModifier regular(ColorCode::FG_DEFAULT, state.color_mode, false);
-        if(state.color_mode == true){
-          std::cout << "[Matching Expression: " << blue << WrapText(match.str(0)) << regular << linelocations.str()  << "]";
-        }
-        else{
-          std::cout << "[Matching Expression: " << WrapText(match.str(0)) << linelocations.str() << "]";
-        }
-        std::cout << "\n\n";
-      }
 
-      // TOGGLE PRINT STATEMENT
-      print_statement = false;
+      ColorModifier blue(ColorCode::FG_BLUE, state.color_mode, true);
+      ColorModifier regular(ColorCode::FG_DEFAULT, state.color_mode, false);
+      if(state.color_mode == true){
+        output << "[Matching Expression: " << blue;
+        WriteWrappedText(output, finding.match, state.line_width);
+        output << regular << linelocations.str()  << "]";
+      }
+      else{
+        output << "[Matching Expression: ";
+        WriteWrappedText(output, finding.match, state.line_width);
+        output << linelocations.str() << "]";
+      }
+      output << "\n\n";
     }
-  } catch (std::regex_error& e) {
-    // Syntax error in the regular expression
+
+    print_statement = false;
   }
-}
 
-void CheckStatement(Configuration& state,
-                    const std::string& sql_statement){
+}
 
-  // TRANSFORM TO LOWER CASE
-  auto statement = sql_statement;
+std::string NormalizeStatement(Configuration& state,
+                               const std::string& sql_statement){
 
-  std::transform(statement.begin(),
-                 statement.end(),
-                 statement.begin(),
-                 ::tolower);
+  TraceSpan span("normalize");
+  CountStatement(sql_statement);
 
   // REMOVE SPACE
-  statement = std::regex_replace(statement, std::regex("^ +| +$|( ) +"), "$1");
+  // (leading and trailing spaces, runs of spaces collapsed to one; the
+  // case is kept, the rules match either case)
+  std::string statement;
+  statement.reserve(sql_statement.size());
+  for (auto c : sql_statement) {
+    if (c == ' ' && (statement.empty() || statement.back() == ' ')) {
+      continue;
+    }
+    statement += c;
+  }
+  if (statement.empty() == false && statement.back() == ' ') {
+    statement.pop_back();
+  }
 
   // CHECK FOR LEADING NEWLINE
   if (statement[0] == '\n') {
@@ -307,81 +559,26 @@ void CheckStatement(Configuration& state,
     state.line_number++;
   }
 
-  // RESET
-  bool print_statement = true;
-
-  // LOGICAL DATABASE DESIGN
-
-  CheckMultiValuedAttribute(state, statement, print_statement);
-
-  CheckRecursiveDependency(state, statement, print_statement);
-
-  CheckPrimaryKeyExists(state, statement, print_statement);
+  // COLLAPSE LISTS OF LITERALS
+  CollapseLiteralLists(statement, state.line_shifts);
 
-  CheckGenericPrimaryKey(state, statement, print_statement);
-
-  CheckForeignKeyExists(state, statement, print_statement);
-
-  CheckVariableAttribute(state, statement, print_statement);
-
-  CheckMetadataTribbles(state, statement, print_statement);
-
-  // PHYSICAL DATABASE DESIGN
-
-  CheckFloat(state, statement, print_statement);
-
-  CheckValuesInDefinition(state, statement, print_statement);
-
-  CheckExternalFiles(state, statement, print_statement);
-
-  CheckIndexCount(state, statement, print_statement);
-
-  CheckIndexAttributeOrder(state, statement, print_statement);
-
-  // QUERY
-
-  CheckSelectStar(state, statement, print_statement);
-
-  CheckJoinWithoutEquality(state, statement, print_statement);
-
-  CheckNullUsage(state, statement, print_statement);
-
-  CheckNotNullUsage(state, statement, print_statement);
-
-  CheckConcatenation(state, statement, print_statement);
-
-  CheckGroupByUsage(state, statement, print_statement);
-
-  CheckOrderByRand(state, statement, print_statement);
-
-  CheckPatternMatching(state, statement, print_statement);
-
-  CheckSpaghettiQuery(state, statement, print_statement);
-
-  CheckJoinCount(state, statement, print_statement);
-
-  CheckDistinctCount(state, statement, print_statement);
-
-  CheckImplicitColumns(state, statement, print_statement);
-
-  CheckHaving(state, statement, print_statement);
-
-  CheckNesting(state, statement, print_statement);
-
-  CheckOr(state, statement, print_statement);
-
-  CheckUnion(state, statement, print_statement);
-
-  CheckDistinctJoin(state, statement, print_statement);
-
-  // APPLICATION
+  return statement;
+}
 
-  CheckReadablePasswords(state, statement, print_statement);
+void CheckStatement(Configuration& state,
+                    const std::string& sql_statement){
 
+  auto statement = NormalizeStatement(state, sql_statement);
 
+  CollectFindings(state, statement);
 
+  PrintFindings(state, statement, std::cout);
 
   // update state.line_number with number of line breaks in the statement that was just checked
+  // (including the ones of collapsed lists)
+  if (state.line_shifts.empty() == false) {
+    state.line_number += state.line_shifts.back().lines;
+  }
   for (size_t i = 0; i < statement.length(); i++)
   {
       if (statement[i] == '\n')
@@ -391,5 +588,35 @@ void CheckStatement(Configuration& state,
   }
 }
 
-}  // namespace machine
+void AnalyzeStatement(Configuration& state,
+                      const std::string& statement){
+  LexKeywords(statement, state.keywords, state.keyword_set);
+  state.statement_kind = ClassifyStatement(state.keywords);
+  state.table_name = GetTableId(statement);
+  state.pattern_matches = ScanPatterns(statement);
+}
+
+void CollectFindings(Configuration& state,
+                     const std::string& statement){
+
+  // RESET
+  state.findings.clear();
+  bool print_statement = true;
+  AnalyzeStatement(state, statement);
+
+  // Only the rules applying to the kind of the statement, whose keywords
+  // are all in the statement
+  const auto& rules = GetRules();
+  for (auto rule : GetStatementRules(state.statement_kind)) {
+    if (state.keyword_set.ContainsAll(rules[rule].keywords) == false) {
+      continue;
+    }
+    TraceSpan span(rules[rule].name, "rule");
+    PerfCounterScope counter_scope(rule);
+    state.rule_index = rule;
+    rules[rule].check(state, statement, print_statement);
+  }
 
+}
+
+}  // namespace machine
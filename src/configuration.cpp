@@ -68,6 +68,44 @@ std::string PatternTypeToString(const PatternType& pattern_type){
 
 }
 
+void FindingCounts::Add(const FindingCounts& counts){
+  for (size_t i = 0; i < kRiskLevelCount; i++) {
+    risk_levels[i] += counts.risk_levels[i];
+  }
+  for (size_t i = 0; i < kPatternTypeCount; i++) {
+    pattern_types[i] += counts.pattern_types[i];
+  }
+  for (size_t i = 0; i < kRuleCount; i++) {
+    rules[i] += counts.rules[i];
+  }
+}
+
+void CheckerStats::Reset(const size_t file_count){
+  statements = 0;
+  bytes = 0;
+  cache_hits = 0;
+  cache_misses = 0;
+  cache_evictions = 0;
+  total = FindingCounts();
+  files.assign(file_count, FindingCounts());
+}
+
+void CheckerStats::CountFile(const Finding& finding, const size_t file_index){
+  if (file_index < files.size()) {
+    auto& counts = files[file_index];
+    counts.risk_levels[finding.risk_level]++;
+    counts.risk_levels[RISK_LEVEL_ALL]++;
+    counts.pattern_types[finding.pattern_type]++;
+    counts.rules[finding.rule]++;
+  }
+}
+
+void CheckerStats::AddFiles(const CheckerStats& stats){
+  for (size_t i = 0; i < files.size() && i < stats.files.size(); i++) {
+    files[i].Add(stats.files[i]);
+  }
+}
+
 std::string GetBooleanString(const bool& status){
   if(status == true){
     return "ENABLED";
@@ -89,7 +127,11 @@ void ValidateRiskLevel(const Configuration &state) {
 }
 
 void ValidateFileName(const Configuration &state) {
-  if (state.file_name.empty() == false) {
+  if (state.file_names.empty() == false) {
+    printf("> %s :: %zu\n", "SQL FILES    ",
+           state.file_names.size());
+  }
+  else if (state.file_name.empty() == false) {
     printf("> %s :: %s\n", "SQL FILE NAME",
            state.file_name.c_str());
   }
@@ -111,4 +153,19 @@ void ValidateDelimiter(const Configuration &state) {
          state.delimiter.c_str());
 }
 
+void ValidateChangedLines(const Configuration &state) {
+  if (state.changed_lines_mode == true && state.file_names.empty() == false) {
+    size_t changed_file_count = 0;
+    for (const auto& changed_lines : state.file_changed_lines) {
+      changed_file_count += (changed_lines.empty() == false);
+    }
+    printf("> %s :: %zu FILES\n", "CHANGED LINES", changed_file_count);
+  }
+  else if (state.changed_lines_mode == true) {
+    auto changed_lines = LineRangesToString(state.changed_lines);
+    printf("> %s :: %s\n", "CHANGED LINES",
+           changed_lines.empty() ? "NONE" : changed_lines.c_str());
+  }
+}
+
 }  // namespace sqlcheck
@@ -0,0 +1,107 @@
+// COUNTERS SOURCE
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "include/counters.h"
+
+namespace sqlcheck {
+
+namespace {
+
+std::mutex counters_mutex;
+
+std::vector<std::unique_ptr<ThreadCounters>> thread_counters;
+
+// Incremented by each run, so that threads drop counters of previous runs
+size_t counters_generation = 0;
+
+thread_local ThreadCounters* current_counters = nullptr;
+
+thread_local size_t current_counters_generation = 0;
+
+}  // namespace
+
+ThreadCounters::ThreadCounters()
+ : statements(0),
+   bytes(0),
+   cache_hits(0),
+   cache_misses(0),
+   cache_evictions(0) {
+  for (auto& counter : risk_levels) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+  for (auto& counter : pattern_types) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+  for (auto& counter : rules) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+}
+
+void ResetCounters(){
+  std::lock_guard<std::mutex> lock(counters_mutex);
+  thread_counters.clear();
+  counters_generation++;
+}
+
+ThreadCounters& GetThreadCounters(){
+  if (current_counters != nullptr && current_counters_generation == counters_generation) {
+    return *current_counters;
+  }
+
+  std::lock_guard<std::mutex> lock(counters_mutex);
+  std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+  current_counters = counters.get();
+  current_counters_generation = counters_generation;
+  thread_counters.push_back(std::move(counters));
+  return *current_counters;
+}
+
+void CountStatement(const std::string& sql_statement){
+  // The fragment after the last delimiter is usually blank
+  if (sql_statement.find_first_not_of(" \t\r\n") == std::string::npos) {
+    return;
+  }
+
+  auto& counters = GetThreadCounters();
+  IncrementCounter(counters.statements);
+  IncrementCounter(counters.bytes, sql_statement.size());
+}
+
+void CountFinding(const Finding& finding){
+  auto& counters = GetThreadCounters();
+  IncrementCounter(counters.risk_levels[finding.risk_level]);
+  IncrementCounter(counters.risk_levels[RISK_LEVEL_ALL]);
+  IncrementCounter(counters.pattern_types[finding.pattern_type]);
+  IncrementCounter(counters.rules[finding.rule]);
+}
+
+CountersSnapshot ReadCounters(){
+  CountersSnapshot snapshot;
+
+  std::lock_guard<std::mutex> lock(counters_mutex);
+  for (const auto& counters : thread_counters) {
+    snapshot.statements += counters->statements.load(std::memory_order_relaxed);
+    snapshot.bytes += counters->bytes.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kRiskLevelCount; i++) {
+      snapshot.findings.risk_levels[i] += counters->risk_levels[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kPatternTypeCount; i++) {
+      snapshot.findings.pattern_types[i] +=
+          counters->pattern_types[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kRuleCount; i++) {
+      snapshot.findings.rules[i] += counters->rules[i].load(std::memory_order_relaxed);
+    }
+    snapshot.cache_hits += counters->cache_hits.load(std::memory_order_relaxed);
+    snapshot.cache_misses += counters->cache_misses.load(std::memory_order_relaxed);
+    snapshot.cache_evictions += counters->cache_evictions.load(std::memory_order_relaxed);
+  }
+
+  return snapshot;
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,144 @@
+// KEYWORD GENERATOR SOURCE
+//
+// Builds the perfect hash table of the keywords (keywords.def) that
+// LookupKeyword searches, written as C++ to the given file:
+//   sqlcheck_generate_keywords keywords.cpp
+// Multipliers are drawn from a fixed sequence until one sends every
+// keyword to its own slot, so the table is the same on every build.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/lexer.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Multipliers tried before giving up
+const size_t kMaxAttemptCount = 1 << 26;
+
+const char* const kKeywordTexts[] = {
+#define SQLCHECK_KEYWORD(identifier, text) text,
+#include "include/keywords.def"
+#undef SQLCHECK_KEYWORD
+};
+
+// Next number of the SplitMix64 sequence
+std::uint64_t NextRandom(std::uint64_t& state){
+  state += 0x9e3779b97f4a7c15ULL;
+  auto value = state;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+// Odd multiplier sending each key to its own slot, 0 if none was found
+std::uint64_t FindMultiplier(const std::vector<std::uint64_t>& keys){
+  std::uint64_t state = 0;
+  std::vector<bool> used(1 << kKeywordSlotBits);
+
+  for (size_t attempt = 0; attempt < kMaxAttemptCount; attempt++) {
+    auto multiplier = NextRandom(state) | 1;
+    std::fill(used.begin(), used.end(), false);
+
+    bool collision = false;
+    for (auto key : keys) {
+      auto slot = GetKeywordSlot(key, multiplier);
+      if (used[slot]) {
+        collision = true;
+        break;
+      }
+      used[slot] = true;
+    }
+    if (collision == false) {
+      return multiplier;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+bool GenerateKeywords(std::ostream& output){
+
+  // Keywords of the same size and outer characters can not be told apart
+  std::vector<std::uint64_t> keys;
+  std::set<std::uint64_t> distinct_keys;
+  for (auto text : kKeywordTexts) {
+    std::string keyword = text;
+    keys.push_back(GetKeywordKey(keyword.data(), keyword.size()));
+    if (distinct_keys.insert(keys.back()).second == false) {
+      std::cerr << "error: keyword " << keyword << " has the hash key of another one\n";
+      return false;
+    }
+  }
+
+  auto multiplier = FindMultiplier(keys);
+  if (multiplier == 0) {
+    std::cerr << "error: no perfect hash multiplier found for the keywords\n";
+    return false;
+  }
+
+  std::vector<unsigned> slots(1 << kKeywordSlotBits);
+  for (size_t keyword = 0; keyword < keys.size(); keyword++) {
+    slots[GetKeywordSlot(keys[keyword], multiplier)] = static_cast<unsigned>(keyword + 1);
+  }
+
+  char hex[32];
+  snprintf(hex, sizeof(hex), "0x%016llxULL", static_cast<unsigned long long>(multiplier));
+
+  output << "// KEYWORDS SOURCE\n"
+         << "//\n"
+         << "// Generated from keywords.def by sqlcheck_generate_keywords, do not edit.\n"
+         << "\n"
+         << "#include \"lexer.h\"\n"
+         << "\n"
+         << "namespace sqlcheck {\n"
+         << "\n"
+         << "const std::uint64_t kKeywordHashMultiplier = " << hex << ";\n"
+         << "\n"
+         << "const std::uint8_t kKeywordSlots[1 << kKeywordSlotBits] = {\n";
+  for (size_t slot = 0; slot < slots.size(); slot++) {
+    output << ((slot % 16 == 0) ? "  " : " ") << slots[slot] << ",";
+    if (slot % 16 == 15) {
+      output << "\n";
+    }
+  }
+  output << "};\n"
+         << "\n"
+         << "}  // namespace sqlcheck\n";
+
+  return true;
+}
+
+}  // namespace sqlcheck
+
+int main(int argc, char** argv){
+
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <output file>\n";
+    return 1;
+  }
+
+  std::stringstream output;
+  if (sqlcheck::GenerateKeywords(output) == false) {
+    return 1;
+  }
+
+  std::ofstream file(argv[1]);
+  file << output.str();
+  file.close();
+  if (file.fail()) {
+    std::cerr << "error: can not write " << argv[1] << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,837 @@
+// MATCHER GENERATOR SOURCE
+//
+// Compiles the built-in patterns (patterns.def) into the state machines of
+// MatchPattern, written as C++ to the given file:
+//   sqlcheck_generate_matchers matchers.cpp
+// Each pattern becomes a deterministic automaton that reads a text once and
+// stops at its first match. Patterns with a construct the generator does not
+// support (anchors, back references, assertions) keep their regex only.
+
+#include <bitset>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "include/patterns.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Largest automaton written for a pattern, larger ones keep their regex only
+const size_t kMaxStateCount = 2048;
+
+const size_t kUnbounded = static_cast<size_t>(-1);
+
+typedef std::bitset<256> ByteSet;
+
+// Node of the syntax tree of a pattern
+struct Node {
+
+  enum Type {
+    NODE_BYTES,
+    NODE_SEQUENCE,
+    NODE_ALTERNATION,
+    NODE_REPETITION
+  };
+
+  Type type;
+
+  // bytes matched by a NODE_BYTES node
+  ByteSet bytes;
+
+  // indexes of the child nodes
+  std::vector<size_t> children;
+
+  // bounds of a NODE_REPETITION node
+  size_t min_count;
+  size_t max_count;
+
+};
+
+// Parser of the ECMAScript patterns of std::regex, without the constructs
+// that a finite automaton can not decide
+class PatternParser {
+
+ public:
+  explicit PatternParser(const std::string& pattern)
+ : pattern_(pattern),
+   position_(0){
+  }
+
+  // Index of the root node, throws std::runtime_error on an unsupported
+  // construct
+  size_t Parse(){
+    auto root = ParseAlternation();
+    if (position_ != pattern_.size()) {
+      Fail("unbalanced parenthesis");
+    }
+    return root;
+  }
+
+  const std::vector<Node>& GetNodes() const {
+    return nodes_;
+  }
+
+ private:
+
+  void Fail(const std::string& reason) const {
+    std::stringstream message;
+    message << reason << " at offset " << position_;
+    throw std::runtime_error(message.str());
+  }
+
+  bool AtEnd() const {
+    return position_ == pattern_.size();
+  }
+
+  unsigned char Peek() const {
+    return static_cast<unsigned char>(pattern_[position_]);
+  }
+
+  size_t AddNode(const Node::Type type){
+    Node node;
+    node.type = type;
+    node.min_count = 0;
+    node.max_count = 0;
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  size_t AddBytes(const ByteSet& bytes){
+    auto node = AddNode(Node::NODE_BYTES);
+    nodes_[node].bytes = bytes;
+    return node;
+  }
+
+  size_t ParseAlternation(){
+    auto alternation = AddNode(Node::NODE_ALTERNATION);
+    auto sequence = ParseSequence();
+    nodes_[alternation].children.push_back(sequence);
+    while (AtEnd() == false && Peek() == '|') {
+      position_++;
+      sequence = ParseSequence();
+      nodes_[alternation].children.push_back(sequence);
+    }
+    return alternation;
+  }
+
+  size_t ParseSequence(){
+    auto sequence = AddNode(Node::NODE_SEQUENCE);
+    while (AtEnd() == false && Peek() != '|' && Peek() != ')') {
+      auto term = ParseTerm();
+      nodes_[sequence].children.push_back(term);
+    }
+    return sequence;
+  }
+
+  size_t ParseTerm(){
+    auto atom = ParseAtom();
+    if (AtEnd()) {
+      return atom;
+    }
+
+    size_t min_count, max_count;
+    switch (Peek()) {
+      case '*':
+        min_count = 0;
+        max_count = kUnbounded;
+        break;
+      case '+':
+        min_count = 1;
+        max_count = kUnbounded;
+        break;
+      case '?':
+        min_count = 0;
+        max_count = 1;
+        break;
+      case '{':
+        ParseBounds(min_count, max_count);
+        break;
+      default:
+        return atom;
+    }
+    position_++;
+
+    // Lazy and greedy repetitions accept the same texts
+    if (AtEnd() == false && Peek() == '?') {
+      position_++;
+    }
+
+    auto repetition = AddNode(Node::NODE_REPETITION);
+    nodes_[repetition].children.push_back(atom);
+    nodes_[repetition].min_count = min_count;
+    nodes_[repetition].max_count = max_count;
+    return repetition;
+  }
+
+  // Bounds of {n}, {n,} or {n,m}, leaving position_ at the closing brace
+  void ParseBounds(size_t& min_count, size_t& max_count){
+    position_++;
+    min_count = ParseNumber();
+    max_count = min_count;
+    if (AtEnd() == false && Peek() == ',') {
+      position_++;
+      max_count = (AtEnd() == false && Peek() == '}') ? kUnbounded : ParseNumber();
+    }
+    if (AtEnd() || Peek() != '}' || max_count < min_count) {
+      Fail("invalid repetition");
+    }
+  }
+
+  size_t ParseNumber(){
+    if (AtEnd() || isdigit(Peek()) == false) {
+      Fail("invalid repetition");
+    }
+    size_t number = 0;
+    while (AtEnd() == false && isdigit(Peek())) {
+      number = number * 10 + (Peek() - '0');
+      position_++;
+      if (number > 1000) {
+        Fail("repetition too large");
+      }
+    }
+    return number;
+  }
+
+  size_t ParseAtom(){
+    auto c = Peek();
+    ByteSet bytes;
+
+    switch (c) {
+      case '(': {
+        position_++;
+        if (AtEnd() == false && Peek() == '?') {
+          if (pattern_.compare(position_, 2, "?:") != 0) {
+            Fail("assertion");
+          }
+          position_ += 2;
+        }
+        auto group = ParseAlternation();
+        if (AtEnd() || Peek() != ')') {
+          Fail("unbalanced parenthesis");
+        }
+        position_++;
+        return group;
+      }
+      case '[':
+        ParseClass(bytes);
+        return AddBytes(bytes);
+      case '.':
+        // Any character but a line terminator
+        position_++;
+        bytes.set();
+        bytes.reset('\n');
+        bytes.reset('\r');
+        return AddBytes(bytes);
+      case '\\':
+        ParseEscape(bytes);
+        return AddBytes(bytes);
+      case '^':
+      case '$':
+        Fail("anchor");
+        break;
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+      case '}':
+      case ']':
+        Fail("misplaced special character");
+        break;
+      default:
+        break;
+    }
+
+    position_++;
+    bytes.set(c);
+    return AddBytes(bytes);
+  }
+
+  // Escape at position_, inside or outside of a class
+  void ParseEscape(ByteSet& bytes){
+    position_++;
+    if (AtEnd()) {
+      Fail("trailing backslash");
+    }
+    auto c = Peek();
+    position_++;
+
+    ByteSet escaped;
+    switch (c) {
+      case 'd':
+      case 'D':
+        for (int digit = '0'; digit <= '9'; digit++) {
+          escaped.set(digit);
+        }
+        break;
+      case 's':
+      case 'S':
+        for (auto space : std::string(" \t\n\v\f\r")) {
+          escaped.set(static_cast<unsigned char>(space));
+        }
+        break;
+      case 'w':
+      case 'W':
+        for (int byte = 0; byte < 128; byte++) {
+          if (isalnum(byte) || byte == '_') {
+            escaped.set(byte);
+          }
+        }
+        break;
+      case 'n':
+        escaped.set('\n');
+        break;
+      case 'r':
+        escaped.set('\r');
+        break;
+      case 't':
+        escaped.set('\t');
+        break;
+      case 'v':
+        escaped.set('\v');
+        break;
+      case 'f':
+        escaped.set('\f');
+        break;
+      default:
+        // Back references, word boundaries and character codes
+        if (isalnum(c)) {
+          position_--;
+          Fail("unsupported escape");
+        }
+        escaped.set(c);
+        break;
+    }
+
+    if (c == 'D' || c == 'S' || c == 'W') {
+      escaped.flip();
+    }
+    bytes |= escaped;
+  }
+
+  void ParseClass(ByteSet& bytes){
+    position_++;
+    bool negated = false;
+    if (AtEnd() == false && Peek() == '^') {
+      negated = true;
+      position_++;
+    }
+    if (AtEnd() == false && Peek() == ']') {
+      Fail("empty class");
+    }
+
+    while (true) {
+      if (AtEnd()) {
+        Fail("unbalanced bracket");
+      }
+      auto c = Peek();
+      if (c == ']') {
+        position_++;
+        break;
+      }
+
+      // Single character or class escape such as \s
+      ByteSet item;
+      if (c == '\\') {
+        ParseEscape(item);
+      }
+      else {
+        item.set(c);
+        position_++;
+      }
+
+      // Range of characters, with a literal '-' at the end of the class
+      if (item.count() == 1 && position_ + 1 < pattern_.size() &&
+          Peek() == '-' && pattern_[position_ + 1] != ']') {
+        position_++;
+        ByteSet last_item;
+        if (Peek() == '\\') {
+          ParseEscape(last_item);
+        }
+        else {
+          last_item.set(Peek());
+          position_++;
+        }
+        size_t first = 0, last = 0;
+        while (item.test(first) == false) {
+          first++;
+        }
+        while (last_item.test(last) == false) {
+          last++;
+        }
+        // Bytes past 0x7f are negative chars to std::regex
+        if (last_item.count() != 1 || last < first || last >= 0x80) {
+          Fail("invalid range");
+        }
+        for (auto byte = first; byte <= last; byte++) {
+          item.set(byte);
+        }
+      }
+
+      bytes |= item;
+    }
+
+    if (negated) {
+      bytes.flip();
+    }
+  }
+
+  const std::string& pattern_;
+
+  size_t position_;
+
+  std::vector<Node> nodes_;
+
+};
+
+// Nondeterministic automaton of a pattern (Thompson construction)
+class Automaton {
+
+ public:
+  explicit Automaton(const std::vector<Node>& nodes)
+ : nodes_(nodes){
+  }
+
+  // Build the automaton of the tree under root
+  void Build(const size_t root){
+    auto fragment = BuildNode(root);
+    start_ = fragment.start;
+    accept_ = fragment.end;
+  }
+
+  // States reached from the given states without reading a byte
+  std::vector<size_t> GetClosure(const std::vector<size_t>& states) const {
+    std::vector<bool> seen(states_.size(), false);
+    std::vector<size_t> stack(states);
+    for (auto state : states) {
+      seen[state] = true;
+    }
+    while (stack.empty() == false) {
+      auto state = stack.back();
+      stack.pop_back();
+      for (auto next : states_[state].epsilons) {
+        if (seen[next] == false) {
+          seen[next] = true;
+          stack.push_back(next);
+        }
+      }
+    }
+
+    std::vector<size_t> closure;
+    for (size_t state = 0; state < states_.size(); state++) {
+      if (seen[state]) {
+        closure.push_back(state);
+      }
+    }
+    return closure;
+  }
+
+  // States reached from the given states by reading a byte
+  std::vector<size_t> GetNext(const std::vector<size_t>& states,
+                              const unsigned char byte) const {
+    std::vector<size_t> next;
+    for (auto state : states) {
+      if (states_[state].bytes.test(byte)) {
+        next.push_back(states_[state].next);
+      }
+    }
+    return next;
+  }
+
+  size_t GetStart() const {
+    return start_;
+  }
+
+  size_t GetAccept() const {
+    return accept_;
+  }
+
+ private:
+
+  struct State {
+
+    // bytes leading to the next state
+    ByteSet bytes;
+    size_t next;
+
+    std::vector<size_t> epsilons;
+
+  };
+
+  struct Fragment {
+
+    size_t start;
+    size_t end;
+
+  };
+
+  size_t AddState(){
+    State state;
+    state.next = 0;
+    states_.push_back(state);
+    return states_.size() - 1;
+  }
+
+  void AddEpsilon(const size_t from, const size_t to){
+    states_[from].epsilons.push_back(to);
+  }
+
+  Fragment BuildNode(const size_t index){
+    const auto& node = nodes_[index];
+    Fragment fragment;
+    fragment.start = AddState();
+
+    switch (node.type) {
+      case Node::NODE_BYTES:
+        fragment.end = AddState();
+        states_[fragment.start].bytes = node.bytes;
+        states_[fragment.start].next = fragment.end;
+        break;
+
+      case Node::NODE_SEQUENCE:
+        fragment.end = fragment.start;
+        for (auto child : node.children) {
+          auto child_fragment = BuildNode(child);
+          AddEpsilon(fragment.end, child_fragment.start);
+          fragment.end = child_fragment.end;
+        }
+        break;
+
+      case Node::NODE_ALTERNATION:
+        fragment.end = AddState();
+        for (auto child : node.children) {
+          auto child_fragment = BuildNode(child);
+          AddEpsilon(fragment.start, child_fragment.start);
+          AddEpsilon(child_fragment.end, fragment.end);
+        }
+        break;
+
+      case Node::NODE_REPETITION: {
+        auto child = node.children.front();
+        fragment.end = fragment.start;
+        for (size_t count = 0; count < node.min_count; count++) {
+          auto child_fragment = BuildNode(child);
+          AddEpsilon(fragment.end, child_fragment.start);
+          fragment.end = child_fragment.end;
+        }
+        if (node.max_count == kUnbounded) {
+          auto loop = AddState();
+          auto child_fragment = BuildNode(child);
+          AddEpsilon(fragment.end, loop);
+          AddEpsilon(loop, child_fragment.start);
+          AddEpsilon(child_fragment.end, loop);
+          fragment.end = loop;
+          break;
+        }
+        for (auto count = node.min_count; count < node.max_count; count++) {
+          auto end = AddState();
+          auto child_fragment = BuildNode(child);
+          AddEpsilon(fragment.end, child_fragment.start);
+          AddEpsilon(fragment.end, end);
+          AddEpsilon(child_fragment.end, end);
+          fragment.end = end;
+        }
+        break;
+      }
+    }
+
+    return fragment;
+  }
+
+  const std::vector<Node>& nodes_;
+
+  std::vector<State> states_;
+
+  size_t start_;
+  size_t accept_;
+
+};
+
+// Transition of a deterministic state to a match
+const size_t kMatchState = static_cast<size_t>(-1);
+
+// Deterministic automaton searching a text for a match of a pattern,
+// starting a new attempt at every byte
+struct SearchAutomaton {
+
+  // whether the empty text matches
+  bool matches_empty;
+
+  // next state of each state for each byte
+  std::vector<std::vector<size_t>> transitions;
+
+};
+
+// Subset construction of the search automaton
+SearchAutomaton BuildSearchAutomaton(const Automaton& automaton){
+  SearchAutomaton search;
+  auto start = automaton.GetClosure(std::vector<size_t>(1, automaton.GetStart()));
+
+  auto is_match = [&automaton](const std::vector<size_t>& states) {
+    for (auto state : states) {
+      if (state == automaton.GetAccept()) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  search.matches_empty = is_match(start);
+  if (search.matches_empty) {
+    return search;
+  }
+
+  std::map<std::vector<size_t>, size_t> state_ids;
+  std::vector<std::vector<size_t>> state_sets;
+  state_ids[start] = 0;
+  state_sets.push_back(start);
+
+  for (size_t state = 0; state < state_sets.size(); state++) {
+    std::vector<size_t> transitions(256);
+    for (size_t byte = 0; byte < 256; byte++) {
+      auto next = automaton.GetNext(state_sets[state], static_cast<unsigned char>(byte));
+
+      // A match may also start at the next byte
+      next.insert(next.end(), start.begin(), start.end());
+      next = automaton.GetClosure(next);
+      if (is_match(next)) {
+        transitions[byte] = kMatchState;
+        continue;
+      }
+
+      auto id = state_ids.find(next);
+      if (id == state_ids.end()) {
+        if (state_sets.size() == kMaxStateCount) {
+          throw std::runtime_error("automaton too large");
+        }
+        id = state_ids.insert(std::make_pair(next, state_sets.size())).first;
+        state_sets.push_back(next);
+      }
+      transitions[byte] = id->second;
+    }
+    search.transitions.push_back(transitions);
+  }
+
+  return search;
+}
+
+// MatchSelectStar for SELECT_STAR
+std::string GetFunctionName(const std::string& identifier){
+  std::string name = "Match";
+  bool capital = true;
+  for (auto c : identifier) {
+    if (c == '_') {
+      capital = true;
+      continue;
+    }
+    name += capital ? c : static_cast<char>(tolower(c));
+    capital = false;
+  }
+  return name;
+}
+
+// Text as a C string literal
+std::string QuoteText(const std::string& text){
+  std::string quoted = "\"";
+  for (auto c : text) {
+    auto byte = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    }
+    else if (isprint(byte) == false) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\x%02x", byte);
+      quoted += escaped;
+    }
+    else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+std::string GetCaseLabel(const size_t byte){
+  std::stringstream label;
+  if (isalnum(static_cast<int>(byte))) {
+    label << "'" << static_cast<char>(byte) << "'";
+  }
+  else {
+    label << "0x" << std::hex << byte;
+  }
+  return label.str();
+}
+
+std::string GetTarget(const size_t state){
+  if (state == kMatchState) {
+    return "return true;";
+  }
+  return "goto state_" + std::to_string(state) + ";";
+}
+
+void WriteFunction(std::ostream& output,
+                   const std::string& name,
+                   const SearchAutomaton& search){
+
+  output << "bool " << name << "(const unsigned char* data, const unsigned char* end){\n";
+  if (search.matches_empty) {
+    output << "  (void) data;\n";
+    output << "  (void) end;\n";
+    output << "  return true;\n";
+    output << "}\n";
+    return;
+  }
+
+  // Labels of the states jumped to
+  std::vector<bool> targets(search.transitions.size(), false);
+  for (const auto& transitions : search.transitions) {
+    for (auto next : transitions) {
+      if (next != kMatchState) {
+        targets[next] = true;
+      }
+    }
+  }
+
+  for (size_t state = 0; state < search.transitions.size(); state++) {
+    const auto& transitions = search.transitions[state];
+
+    // Bytes of each next state, the most common one being the default
+    std::map<size_t, std::vector<size_t>> bytes_of_next;
+    for (size_t byte = 0; byte < 256; byte++) {
+      bytes_of_next[transitions[byte]].push_back(byte);
+    }
+    auto default_next = bytes_of_next.begin();
+    for (auto next = bytes_of_next.begin(); next != bytes_of_next.end(); ++next) {
+      if (next->second.size() > default_next->second.size()) {
+        default_next = next;
+      }
+    }
+
+    if (targets[state]) {
+      output << " state_" << state << ":\n";
+    }
+    output << "  if (data == end) {\n";
+    output << "    return false;\n";
+    output << "  }\n";
+    output << "  switch (*data++) {\n";
+    for (auto next = bytes_of_next.begin(); next != bytes_of_next.end(); ++next) {
+      if (next == default_next) {
+        continue;
+      }
+      for (size_t index = 0; index < next->second.size(); index++) {
+        output << (index % 8 == 0 ? "    " : " ");
+        output << "case " << GetCaseLabel(next->second[index]) << ":";
+        if (index % 8 == 7 || index + 1 == next->second.size()) {
+          output << "\n";
+        }
+      }
+      output << "      " << GetTarget(next->first) << "\n";
+    }
+    output << "    default:\n";
+    output << "      " << GetTarget(default_next->first) << "\n";
+    output << "  }\n";
+  }
+
+  output << "}\n";
+}
+
+struct BuiltInPattern {
+
+  const char* identifier;
+  PatternId pattern;
+
+};
+
+const BuiltInPattern kBuiltInPatterns[] = {
+#define SQLCHECK_PATTERN(identifier, pattern) {#identifier, PATTERN_##identifier},
+#include "include/patterns.def"
+#undef SQLCHECK_PATTERN
+};
+
+}  // namespace
+
+void GenerateMatchers(std::ostream& output){
+
+  output << "// MATCHERS SOURCE\n";
+  output << "//\n";
+  output << "// Generated by sqlcheck_generate_matchers from patterns.def, do not edit.\n";
+  output << "\n";
+  output << "#include \"matcher.h\"\n";
+  output << "\n";
+  output << "namespace sqlcheck {\n";
+  output << "\n";
+  output << "namespace {\n";
+
+  std::vector<bool> generated(kPatternCount, false);
+  for (const auto& built_in : kBuiltInPatterns) {
+    std::string text = GetPatternText(built_in.pattern);
+    auto folded = FoldPatternCase(text);
+
+    try {
+      PatternParser parser(folded);
+      auto root = parser.Parse();
+      Automaton automaton(parser.GetNodes());
+      automaton.Build(root);
+      auto search = BuildSearchAutomaton(automaton);
+
+      output << "\n";
+      output << "// " << QuoteText(text) << "\n";
+      WriteFunction(output, GetFunctionName(built_in.identifier), search);
+      generated[built_in.pattern] = true;
+    }
+    catch (std::runtime_error& error) {
+      std::cerr << "warning: pattern " << built_in.identifier << " keeps its regex only ("
+                << error.what() << ")\n";
+    }
+  }
+
+  output << "\n";
+  output << "}  // namespace\n";
+  output << "\n";
+  output << "bool MatchPattern(const PatternId pattern, const char* data, const size_t size){\n";
+  output << "  auto begin = reinterpret_cast<const unsigned char*>(data);\n";
+  output << "  switch (pattern) {\n";
+  for (const auto& built_in : kBuiltInPatterns) {
+    if (generated[built_in.pattern] == false) {
+      continue;
+    }
+    output << "    case PATTERN_" << built_in.identifier << ":\n";
+    output << "      return " << GetFunctionName(built_in.identifier) << "(begin, begin + size);\n";
+  }
+  output << "    default:\n";
+  output << "      return true;\n";
+  output << "  }\n";
+  output << "}\n";
+  output << "\n";
+  output << "}  // namespace sqlcheck\n";
+}
+
+}  // namespace sqlcheck
+
+int main(int argc, char** argv){
+
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <output file>\n";
+    return 1;
+  }
+
+  std::stringstream output;
+  sqlcheck::GenerateMatchers(output);
+
+  std::ofstream file(argv[1]);
+  file << output.str();
+  file.close();
+  if (file.fail()) {
+    std::cerr << "error: can not write " << argv[1] << "\n";
+    return 1;
+  }
+
+  return 0;
+}
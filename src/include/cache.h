@@ -0,0 +1,147 @@
+// CACHE HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "configuration.h"
+
+namespace sqlcheck {
+
+// 128-bit hash of a normalized statement, with its length
+struct StatementFingerprint {
+
+  bool operator==(const StatementFingerprint& other) const {
+    return high == other.high && low == other.low && length == other.length;
+  }
+
+  std::uint64_t high;
+  std::uint64_t low;
+  std::uint64_t length;
+
+};
+
+// Statements whose lists were collapsed differently get different
+// fingerprints, as the lines of their findings differ
+StatementFingerprint GetStatementFingerprint(const std::string& statement,
+                                             const LineShifts& line_shifts);
+
+// Findings of the normalized statements checked in a run, shared by the
+// checker threads so that repeated statements are checked once. Each shard
+// keeps its share of the capacity, evicting entries that were not found
+// since the clock hand last passed them (CLOCK). Hits, misses and
+// evictions are counted in the counters of the calling thread.
+class FindingCache {
+
+ public:
+  // Keep up to capacity bytes of findings (nothing if 0)
+  explicit FindingCache(const size_t capacity);
+
+  // Copy the findings of a statement checked before, returns false if the
+  // statement was not checked yet or was evicted
+  bool Find(const StatementFingerprint& fingerprint,
+            std::vector<Finding>& findings);
+
+  // Remember the findings of a statement
+  void Insert(const StatementFingerprint& fingerprint,
+              const std::vector<Finding>& findings);
+
+  // Bytes of the entries
+  size_t GetSize();
+
+  FindingCache(const FindingCache&) = delete;
+  FindingCache& operator=(const FindingCache&) = delete;
+
+ private:
+
+  struct FingerprintHash {
+    size_t operator()(const StatementFingerprint& fingerprint) const {
+      return static_cast<size_t>(fingerprint.low);
+    }
+  };
+
+  // Finding whose title and message are kept once for the whole cache
+  struct CachedFinding {
+
+    size_t rule;
+    RiskLevel risk_level;
+    PatternType pattern_type;
+    const std::string* title;
+    const std::string* message;
+    bool exists;
+    std::string match;
+    std::vector<std::uint32_t> lines;
+
+  };
+
+  struct Entry {
+
+    StatementFingerprint fingerprint;
+
+    // shared, to copy them outside of the lock (nullptr if the slot is free)
+    std::shared_ptr<const std::vector<CachedFinding>> findings;
+
+    // estimated bytes of the entry
+    size_t size;
+
+    // found since the clock hand last passed the entry
+    bool referenced;
+
+  };
+
+  // Statements are spread over shards with a lock each
+  static const size_t kShardCount = 64;
+
+  struct Shard {
+
+    Shard()
+     : hand(0),
+       size(0) {
+    }
+
+    std::mutex mutex;
+
+    // slots swept by the clock hand
+    std::vector<Entry> entries;
+
+    // free slots of entries
+    std::vector<size_t> free_slots;
+
+    // slot of each fingerprint
+    std::unordered_map<StatementFingerprint, size_t, FingerprintHash> index;
+
+    size_t hand;
+
+    // bytes of the entries
+    size_t size;
+
+  };
+
+  Shard& GetShard(const StatementFingerprint& fingerprint) {
+    return shards_[fingerprint.high % kShardCount];
+  }
+
+  // Evict entries until size more bytes fit in the shard
+  void Evict(Shard& shard, const size_t size);
+
+  // Shared copy of a title or message
+  const std::string* GetText(const std::string& text);
+
+  // capacity of each shard
+  const size_t shard_capacity_;
+
+  Shard shards_[kShardCount];
+
+  // titles and messages of the rules, a few dozens
+  std::mutex texts_mutex_;
+  std::unordered_set<std::string> texts_;
+
+};
+
+}  // namespace sqlcheck
@@ -0,0 +1,42 @@
+// CHANGES HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlcheck {
+
+// Sorted, non-overlapping ranges of line numbers (both ends inclusive)
+typedef std::vector<std::pair<std::uint32_t, std::uint32_t>> LineRanges;
+
+// Parse either a unified diff file or an inline line range spec
+// (e.g. "10-20,35" or "schema.sql:10-20,35") and collect the
+// lines changed in the given file
+bool ParseChangedLines(const std::string& spec,
+                       const std::string& file_name,
+                       LineRanges& ranges);
+
+// Collect the lines added or modified in the given file by a unified diff
+void ParseUnifiedDiff(std::istream& diff,
+                      const std::string& file_name,
+                      LineRanges& ranges);
+
+// Parse a comma-separated list of line numbers and line ranges
+bool ParseLineRanges(const std::string& spec,
+                     LineRanges& ranges);
+
+// Sort and merge overlapping or adjacent ranges
+void NormalizeLineRanges(LineRanges& ranges);
+
+// Check if the given span of lines overlaps a changed range
+bool OverlapsLineRanges(const LineRanges& ranges,
+                        const std::uint32_t first_line,
+                        const std::uint32_t last_line);
+
+std::string LineRangesToString(const LineRanges& ranges);
+
+}  // namespace sqlcheck
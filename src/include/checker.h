@@ -5,25 +5,63 @@
 #include <regex>
 
 #include "configuration.h"
+#include "matcher.h"
 
 namespace sqlcheck {
 
 // Check a set of SQL statements
 bool Check(Configuration& state);
 
-// Check a SQL statement
+// Check a SQL statement and print its findings
 void CheckStatement(Configuration& state,
                     const std::string& sql_statement);
 
+// Collapse the spaces and the lists of literals of a SQL statement
+std::string NormalizeStatement(Configuration& state,
+                               const std::string& sql_statement);
+
+// Lex and classify a normalized statement for its checks
+void AnalyzeStatement(Configuration& state,
+                      const std::string& statement);
+
+// Check a normalized statement and collect its findings in state.findings
+void CollectFindings(Configuration& state,
+                     const std::string& statement);
+
+// Performance counter slot of whole statements, after the slots of the rules
+size_t GetStatementCounterSlot();
+
+// Write text wrapped at line_length columns, starting a paragraph at each
+// bullet (verbatim if line_length is 0)
+void WriteWrappedText(std::ostream& output,
+                      const std::string& text,
+                      const size_t line_length);
+
+// Wrap text at line_length columns
+std::string WrapText(const std::string& text, const size_t line_length = 80);
+
+// Print the header of a normalized statement found at the given lines
+void PrintStatement(Configuration& state,
+                    std::ostream& output,
+                    const std::string& statement,
+                    const std::vector<std::uint32_t>& lines);
+
+// Print the findings of a normalized statement, after the statement
+// unless print_statement is false
+void PrintFindings(Configuration& state,
+                   const std::string& statement,
+                   std::ostream& output,
+                   bool print_statement = true);
+
 // Check a pattern
 void CheckPattern(Configuration& state,
                   const std::string& sql_statement,
                   bool& print_statement,
-                  const std::regex& anti_pattern,
+                  const Matcher& anti_pattern,
                   const RiskLevel pattern_level,
                   const PatternType pattern_type,
-                  const std::string title,
-                  const std::string message,
+                  const std::string& title,
+                  const std::string& message,
                   const bool exists,
                   const size_t min_count = 0);
 
@@ -8,6 +8,13 @@
 #include <sstream>
 #include <memory>
 #include <map>
+#include <vector>
+
+#include "changes.h"
+#include "interner.h"
+#include "lexer.h"
+#include "literals.h"
+#include "patterns.h"
 
 namespace sqlcheck {
 
@@ -34,15 +41,88 @@ enum PatternType {
 
 };
 
-// Checker stats
+// Sizes of the counts indexed by risk level, pattern type and rule
+const size_t kRiskLevelCount = RISK_LEVEL_HIGH + 1;
+const size_t kPatternTypeCount = PATTERN_TYPE_APPLICATION + 1;
+
+// Number of rules of GetRules()
+const size_t kRuleCount = 30;
+
+// Anti-pattern found in a statement
+struct Finding {
+
+  // index of the rule in GetRules()
+  size_t rule;
+
+  RiskLevel risk_level;
+  PatternType pattern_type;
+  std::string title;
+  std::string message;
+
+  // whether the pattern matched (as opposed to a missing pattern)
+  bool exists;
+
+  // last matching expression
+  std::string match;
+
+  // lines of the matches, relative to the first line of the statement
+  std::vector<std::uint32_t> lines;
+
+};
+
+// Counts of findings by risk level (RISK_LEVEL_ALL counts all of them), by
+// pattern type and by rule
+struct FindingCounts {
+
+  FindingCounts()
+   : risk_levels(),
+     pattern_types(),
+     rules() {
+  }
+
+  void Add(const FindingCounts& counts);
+
+  std::uint64_t risk_levels[kRiskLevelCount];
+
+  std::uint64_t pattern_types[kPatternTypeCount];
+
+  std::uint64_t rules[kRuleCount];
+
+};
+
+// Checker stats of a run, the totals are read from the thread counters
+// once the statements are checked
 struct CheckerStats {
 
-  unsigned int error_level_counter = 0;
-  unsigned int warn_level_counter = 0;
-  unsigned int info_level_counter = 0;
-  unsigned int debug_level_counter = 0;
-  unsigned int trace_level_counter = 0;
-  unsigned int all_level_counter = 0;
+  CheckerStats()
+   : statements(0),
+     bytes(0),
+     cache_hits(0),
+     cache_misses(0),
+     cache_evictions(0) {
+  }
+
+  // Clear the counts, for files indexed like Configuration::file_names
+  void Reset(const size_t file_count);
+
+  // Count a finding in its file (ignored without file_names)
+  void CountFile(const Finding& finding, const size_t file_index);
+
+  // Merge the counts per file of another thread
+  void AddFiles(const CheckerStats& stats);
+
+  // statements that are not blank, and their bytes
+  std::uint64_t statements;
+  std::uint64_t bytes;
+
+  FindingCounts total;
+
+  std::vector<FindingCounts> files;
+
+  // lookups and evictions of the finding cache
+  std::uint64_t cache_hits;
+  std::uint64_t cache_misses;
+  std::uint64_t cache_evictions;
 
 };
 
@@ -55,9 +135,22 @@ class Configuration {
      color_mode(true),
      file_name(""),
      delimiter(";"),
+     backslash_escapes(false),
      risk_level(RiskLevel::RISK_LEVEL_ALL),
      verbose(false),
-     testing_mode(false) {
+     testing_mode(false),
+     changed_lines_mode(false),
+     thread_count(1),
+     trace_file(""),
+     perf_counters_mode(false),
+     line_width(80),
+     dedup_mode(false),
+     cache_size(16 << 20),
+     file_index(0),
+     rule_index(0),
+     statement_kind(STATEMENT_KIND_OTHER),
+     table_name(kNoStringId),
+     pattern_matches(kAllPatterns) {
   }
 
   // color mode
@@ -66,9 +159,15 @@ class Configuration {
   // filename
   std::string file_name;
 
+  // files checked one after the other (directory or several file names)
+  std::vector<std::string> file_names;
+
   // query delimiter
   std::string delimiter;
 
+  // backslashes escape quotes in strings (MySQL)
+  bool backslash_escapes;
+
   // risk level
   RiskLevel risk_level;
 
@@ -76,17 +175,68 @@ class Configuration {
   bool verbose;
 
   // test stream
-  std::unique_ptr<std::istringstream> test_stream;
+  std::shared_ptr<std::istringstream> test_stream;
 
   // testing mode
   bool testing_mode;
 
   /// checker stats
-  std::map<int, int> checker_stats;
+  CheckerStats checker_stats;
 
   // line number
   std::uint32_t line_number;
 
+  // lines removed by collapsing lists of the last normalized statement
+  LineShifts line_shifts;
+
+  // only check statements overlapping the changed lines
+  bool changed_lines_mode;
+
+  // changed lines
+  LineRanges changed_lines;
+
+  // changed lines of each of file_names
+  std::vector<LineRanges> file_changed_lines;
+
+  // findings of the last checked statement
+  std::vector<Finding> findings;
+
+  // number of checker threads
+  size_t thread_count;
+
+  // Chrome trace-event file of the stages and rules (none by default)
+  std::string trace_file;
+
+  // report hardware performance counters per statement and per rule
+  bool perf_counters_mode;
+
+  // columns of the wrapped output (0 to print statements verbatim)
+  size_t line_width;
+
+  // print each distinct statement of a file once, with its occurrences
+  bool dedup_mode;
+
+  // bytes of findings remembered for repeated statements (0 to check
+  // every statement)
+  size_t cache_size;
+
+  // index of file_name in file_names
+  size_t file_index;
+
+  // index in GetRules() of the rule being checked
+  size_t rule_index;
+
+  // keywords and kind of the statement being checked
+  std::vector<Keyword> keywords;
+  KeywordSet keyword_set;
+  StatementKind statement_kind;
+
+  // table created by the statement being checked (kNoStringId if none)
+  StringId table_name;
+
+  // built-in patterns that may match the statement being checked
+  PatternSet pattern_matches;
+
 };
 
 std::string RiskLevelToString(const RiskLevel& risk_level);
@@ -105,5 +255,7 @@ void ValidateVerbose(const Configuration &state);
 
 void ValidateDelimiter(const Configuration &state);
 
+void ValidateChangedLines(const Configuration &state);
+
 
 }  // namespace sqlcheck
@@ -0,0 +1,88 @@
+// COUNTERS HEADER
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "configuration.h"
+
+namespace sqlcheck {
+
+// Bytes of a cache line, padding counters of different threads apart
+const size_t kCacheLineSize = 64;
+
+// Counters of the statements and findings of a thread. Only the thread
+// writes them, without read-modify-writes, while any thread may read them.
+struct ThreadCounters {
+
+  ThreadCounters();
+
+  // keeps the counters off the cache lines of neighbouring allocations
+  char leading_padding[kCacheLineSize];
+
+  // statements that are not blank, and their bytes
+  std::atomic<std::uint64_t> statements;
+  std::atomic<std::uint64_t> bytes;
+
+  // findings, indexed like FindingCounts
+  std::atomic<std::uint64_t> risk_levels[kRiskLevelCount];
+  std::atomic<std::uint64_t> pattern_types[kPatternTypeCount];
+  std::atomic<std::uint64_t> rules[kRuleCount];
+
+  // lookups and evictions of the finding cache
+  std::atomic<std::uint64_t> cache_hits;
+  std::atomic<std::uint64_t> cache_misses;
+  std::atomic<std::uint64_t> cache_evictions;
+
+  char trailing_padding[kCacheLineSize];
+
+};
+
+// Sum of the counters of every thread
+struct CountersSnapshot {
+
+  CountersSnapshot()
+   : statements(0),
+     bytes(0),
+     cache_hits(0),
+     cache_misses(0),
+     cache_evictions(0) {
+  }
+
+  std::uint64_t statements;
+
+  std::uint64_t bytes;
+
+  FindingCounts findings;
+
+  std::uint64_t cache_hits;
+  std::uint64_t cache_misses;
+  std::uint64_t cache_evictions;
+
+};
+
+// Drop the counters of a previous run, only while no other thread counts
+void ResetCounters();
+
+// Counters of the calling thread, registered on first use
+ThreadCounters& GetThreadCounters();
+
+// Add to a counter of the calling thread
+inline void IncrementCounter(std::atomic<std::uint64_t>& counter,
+                             const std::uint64_t value = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+// Count a statement of the calling thread
+void CountStatement(const std::string& sql_statement);
+
+// Count a finding of the calling thread
+void CountFinding(const Finding& finding);
+
+// Sum the counters of every thread, from any thread at any time (counts
+// of threads still running may be behind by a few increments)
+CountersSnapshot ReadCounters();
+
+}  // namespace sqlcheck
@@ -0,0 +1,93 @@
+// INTERNER HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+// Small integer standing for an identifier, equal ids for equal text
+typedef std::uint32_t StringId;
+
+// Id of no identifier (an empty table name, for example)
+const StringId kNoStringId = 0;
+
+// 64-bit hash of a text (wyhash)
+std::uint64_t HashString(const char* data, const size_t size);
+
+// Identifiers kept once each, with their text in an arena. Ids are dense,
+// starting from 1, so that tables of identifiers can be indexed by them.
+// Interning and looking up are safe from any thread.
+class StringInterner {
+
+ public:
+  StringInterner();
+
+  // Id of a text, kNoStringId for the empty text
+  StringId Intern(const std::string& text);
+
+  // Id of a text interned before, kNoStringId if there is none
+  StringId Find(const std::string& text);
+
+  // Text of an id (null-terminated, valid until Clear)
+  const char* GetData(const StringId id);
+
+  size_t GetSize(const StringId id);
+
+  std::string GetString(const StringId id);
+
+  // Number of texts interned
+  size_t GetCount();
+
+  // Bytes of the arena and of the tables
+  size_t GetMemoryUsage();
+
+  // Forget all texts, invalidating their ids
+  void Clear();
+
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+
+ private:
+
+  struct Entry {
+
+    const char* data;
+    std::uint32_t size;
+    std::uint64_t hash;
+
+  };
+
+  // Slot of a text in slots_, holding its id or kNoStringId if the text
+  // was not interned
+  size_t FindSlot(const char* data, const size_t size, const std::uint64_t hash) const;
+
+  // Copy of a text in the arena
+  const char* Store(const char* data, const size_t size);
+
+  void Grow();
+
+  std::mutex mutex_;
+
+  // blocks of texts, new texts are appended to the last one
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t block_used_;
+  size_t block_size_;
+  size_t arena_size_;
+
+  // entry of each id, entries_[0] stands for kNoStringId
+  std::vector<Entry> entries_;
+
+  // open addressing table of ids (linear probing, power of two)
+  std::vector<StringId> slots_;
+
+};
+
+// Interner of the current run or LSP edit, cleared when one starts
+StringInterner& GetInterner();
+
+}  // namespace sqlcheck
@@ -0,0 +1,57 @@
+// JSON HEADER
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+enum JsonType {
+  JSON_TYPE_NULL = 0,
+  JSON_TYPE_BOOL = 1,
+  JSON_TYPE_NUMBER = 2,
+  JSON_TYPE_STRING = 3,
+  JSON_TYPE_ARRAY = 4,
+  JSON_TYPE_OBJECT = 5
+};
+
+// Parsed JSON document
+struct JsonValue {
+
+  JsonValue()
+   : type(JSON_TYPE_NULL),
+     boolean(false),
+     number(0) {
+  }
+
+  // Member of an object (null value if missing)
+  const JsonValue& Get(const std::string& key) const;
+
+  bool IsNull() const { return type == JSON_TYPE_NULL; }
+
+  JsonType type;
+
+  bool boolean;
+
+  double number;
+
+  std::string string;
+
+  std::vector<JsonValue> array;
+
+  std::map<std::string, JsonValue> object;
+
+};
+
+// Parse a JSON document
+bool ParseJson(const std::string& text, JsonValue& value);
+
+// Serialize a JSON value
+std::string ToJson(const JsonValue& value);
+
+// Append a string as a quoted and escaped JSON string
+void AppendJsonString(std::string& output, const std::string& str);
+
+}  // namespace sqlcheck
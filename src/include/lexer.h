@@ -0,0 +1,139 @@
+// LEXER HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+// SQL keywords of the supported dialects (keywords.def)
+enum Keyword : std::uint8_t {
+
+  KEYWORD_NONE = 0,
+#define SQLCHECK_KEYWORD(identifier, text) KEYWORD_##identifier,
+#include "keywords.def"
+#undef SQLCHECK_KEYWORD
+
+};
+
+// Number of keywords, including KEYWORD_NONE
+const size_t kKeywordCount = 1 +
+#define SQLCHECK_KEYWORD(identifier, text) 1 +
+#include "keywords.def"
+#undef SQLCHECK_KEYWORD
+    0;
+
+static_assert(kKeywordCount <= 256, "a Keyword is a byte");
+
+// Words are hashed by their first two and last two characters in lower
+// case and their size, multiplied by kKeywordHashMultiplier, to
+// kKeywordSlotBits bits. kKeywordSlots holds the only keyword each slot
+// may be. The multiplier is searched so that no two keywords share a slot,
+// and both are written to keywords.cpp by sqlcheck_generate_keywords when
+// sqlcheck is built.
+const unsigned kKeywordSlotBits = 10;
+extern const std::uint64_t kKeywordHashMultiplier;
+extern const std::uint8_t kKeywordSlots[1 << kKeywordSlotBits];
+
+// Lower case of an ASCII letter, other bytes as they are
+inline std::uint64_t FoldKeywordCase(const unsigned char c){
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Hashed characters and size of a word of at least two characters
+inline std::uint64_t GetKeywordKey(const char* data, const size_t size){
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  return FoldKeywordCase(bytes[0]) |
+      (FoldKeywordCase(bytes[1]) << 8) |
+      (FoldKeywordCase(bytes[size - 2]) << 16) |
+      (FoldKeywordCase(bytes[size - 1]) << 24) |
+      (static_cast<std::uint64_t>(size) << 32);
+}
+
+inline size_t GetKeywordSlot(const std::uint64_t key, const std::uint64_t multiplier){
+  return static_cast<size_t>((key * multiplier) >> (64 - kKeywordSlotBits));
+}
+
+// Set of keywords, one bit per Keyword
+struct KeywordSet {
+
+  KeywordSet()
+   : words() {
+  }
+
+  KeywordSet(std::initializer_list<Keyword> keywords)
+   : words() {
+    for (auto keyword : keywords) {
+      Add(keyword);
+    }
+  }
+
+  void Add(const Keyword keyword) {
+    words[keyword / 64] |= std::uint64_t(1) << (keyword % 64);
+  }
+
+  bool Contains(const Keyword keyword) const {
+    return (words[keyword / 64] >> (keyword % 64)) & 1;
+  }
+
+  // Whether all the keywords of other are in the set
+  bool ContainsAll(const KeywordSet& other) const {
+    std::uint64_t missing = 0;
+    for (size_t i = 0; i < kWordCount; i++) {
+      missing |= other.words[i] & ~words[i];
+    }
+    return missing == 0;
+  }
+
+  static const size_t kWordCount = (kKeywordCount + 63) / 64;
+
+  std::uint64_t words[kWordCount];
+
+};
+
+// Kind of a statement, from its leading keywords
+enum StatementKind {
+
+  STATEMENT_KIND_OTHER = 0,
+  STATEMENT_KIND_SELECT,
+  STATEMENT_KIND_INSERT,
+  STATEMENT_KIND_UPDATE,
+  STATEMENT_KIND_DELETE,
+  STATEMENT_KIND_CREATE_TABLE,
+  STATEMENT_KIND_CREATE_TABLE_AS_SELECT,
+  STATEMENT_KIND_ALTER_TABLE,
+  STATEMENT_KIND_CREATE_INDEX,
+
+  // views, functions, triggers and other objects, whose bodies hold queries
+  STATEMENT_KIND_CREATE_OTHER
+
+};
+
+const size_t kStatementKindCount = STATEMENT_KIND_CREATE_OTHER + 1;
+
+// Keyword of a word in any case, KEYWORD_NONE if it is not one. Words are
+// hashed to a slot of a table generated for the keywords (a perfect hash),
+// which is then confirmed with one comparison.
+Keyword LookupKeyword(const char* data, const size_t size);
+
+// Lower case text of a keyword
+const char* GetKeywordName(const Keyword keyword);
+
+// Keywords of a normalized statement in order, skipping strings, quoted
+// identifiers, comments and numbers. The set also has the keywords of the
+// words in strings, quoted identifiers and comments, which the patterns of
+// the rules see as well.
+void LexKeywords(const std::string& statement, std::vector<Keyword>& keywords,
+                 KeywordSet& keyword_set);
+
+// Kind of a statement from its keywords
+StatementKind ClassifyStatement(const std::vector<Keyword>& keywords);
+
+// Offset after a quoted string or identifier starting at position (quotes
+// are escaped by doubling them or with a backslash), npos if unterminated
+size_t SkipQuotedText(const std::string& text, size_t position);
+
+}  // namespace sqlcheck
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "configuration.h"
 
 namespace sqlcheck {
@@ -134,5 +137,61 @@ void CheckReadablePasswords(Configuration& state,
                             const std::string& sql_statement,
                             bool& print_statement);
 
+// RULES
+
+// Check of an anti-pattern, appends its findings to state.findings
+typedef void (*CheckFunction)(Configuration& state,
+                              const std::string& sql_statement,
+                              bool& print_statement);
+
+// Set of statement kinds, one bit per StatementKind
+typedef std::uint32_t StatementKinds;
+
+const StatementKinds kAllStatementKinds = (1u << kStatementKindCount) - 1;
+
+// Statements defining the columns of a table
+const StatementKinds kCreateTableKinds =
+    (1u << STATEMENT_KIND_CREATE_TABLE) | (1u << STATEMENT_KIND_CREATE_TABLE_AS_SELECT);
+
+const StatementKinds kTableDefinitionKinds =
+    kCreateTableKinds | (1u << STATEMENT_KIND_ALTER_TABLE);
+
+// Statements that may hold queries
+const StatementKinds kQueryKinds =
+    kAllStatementKinds & ~((1u << STATEMENT_KIND_CREATE_TABLE) |
+                           (1u << STATEMENT_KIND_ALTER_TABLE) |
+                           (1u << STATEMENT_KIND_CREATE_INDEX));
+
+// Anti-pattern rule
+struct Rule {
+
+  // name of the rule in traces and reports
+  const char* name;
+
+  CheckFunction check;
+
+  // kinds of the statements the rule applies to
+  StatementKinds kinds;
+
+  // keywords a statement must all have for the rule to match (none by
+  // default), so that other statements are skipped with a few instructions.
+  // Only words the pattern needs whole, between characters that cannot be
+  // in a word, may be listed: "(null)" also matches ifnull, so its rule
+  // has no keywords.
+  KeywordSet keywords;
+
+};
+
+// Rules in the order their findings are printed
+const std::vector<Rule>& GetRules();
+
+// Indexes in GetRules() of the rules applying to a kind of statement, in
+// order
+const std::vector<size_t>& GetStatementRules(const StatementKind kind);
+
+// Interned name of the table created by a normalized statement
+// (kNoStringId if it creates none)
+StringId GetTableId(const std::string& sql_statement);
+
 
 }  // namespace machine
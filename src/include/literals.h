@@ -0,0 +1,45 @@
+// LITERALS HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+// Lines removed from a statement by collapsing a list, in total up to an
+// offset of the collapsed text
+struct LineShift {
+
+  // offset in the collapsed text, just after the placeholder
+  size_t offset;
+
+  // lines removed before offset
+  std::uint32_t lines;
+
+};
+
+// Shifts of a collapsed statement, in order of their offsets
+typedef std::vector<LineShift> LineShifts;
+
+// Lists of at least this many literals, and runs of at least this many
+// tuples of literals, are collapsed
+const size_t kCollapsedListSize = 16;
+
+// Collapse long lists of literals of a normalized statement to their first
+// item and a placeholder, so that rules do not scan bulk data:
+//   in (1, 2, ..., 1000)                 ->  in (1, ?)
+//   values (1, 'a'), ..., (1000, 'z')    ->  values (1, 'a'), (?)
+// The placeholder ends with null if a removed literal is NULL:
+//   in (1, null, ..., 1000)              ->  in (1, ?, null)
+//   values (1, 'a'), (null, 'b'), ...    ->  values (1, 'a'), (?, null)
+// Lists whose removed literals match another built-in pattern (0.0001 or
+// 'password = x', for example) are kept as they are.
+// line_shifts receives the lines removed (none if nothing was collapsed)
+void CollapseLiteralLists(std::string& statement, LineShifts& line_shifts);
+
+// Lines removed before an offset of a collapsed statement
+std::uint32_t GetRemovedLines(const LineShifts& line_shifts, const size_t offset);
+
+}  // namespace sqlcheck
@@ -0,0 +1,142 @@
+// LSP HEADER
+
+#pragma once
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "configuration.h"
+#include "json.h"
+
+namespace sqlcheck {
+
+// Diagnostic of a statement, serialized once and reused until its line changes
+struct LspDiagnostic {
+
+  // line relative to the first line of the statement
+  std::uint32_t line;
+
+  // UTF-16 character range within the line
+  size_t start_character;
+  size_t end_character;
+
+  // serialized severity, source, code and message
+  std::string body;
+
+};
+
+// Statement of an open document
+struct LspStatement {
+
+  // byte offset of the statement text
+  size_t offset;
+
+  // length of the statement text, excluding the delimiter
+  size_t length;
+
+  // zero-based line of the first byte of the statement
+  std::uint32_t line;
+
+  // lines skipped by normalization before the first line of the findings
+  std::uint32_t line_adjust;
+
+  // cached findings of the statement
+  std::vector<Finding> findings;
+
+  // cached diagnostics of the findings
+  std::vector<LspDiagnostic> diagnostics;
+
+  // whether the cached diagnostics match the document text
+  bool has_diagnostics;
+
+  // serialized diagnostics, valid while the statement stays on published_line
+  std::string published;
+  std::uint32_t published_line;
+
+};
+
+// Document opened by the client
+struct LspDocument {
+
+  std::string text;
+
+  // statements covering the whole text, in order
+  std::vector<LspStatement> statements;
+
+};
+
+// Language server that re-checks only the statements touched by each edit
+class LspServer {
+
+ public:
+  LspServer(Configuration& state, std::ostream& output);
+
+  // Handle a JSON-RPC message, returns false once the client asked to exit
+  bool HandleMessage(const std::string& message);
+
+  // Whether the client requested a shutdown before exiting
+  bool IsShutdown() const { return shutdown_; }
+
+  // Number of statements checked since the server started
+  size_t GetCheckedStatementCount() const { return checked_statement_count_; }
+
+  // Open document (nullptr if the document is not open)
+  const LspDocument* GetDocument(const std::string& uri) const;
+
+ private:
+
+  void HandleRequest(const JsonValue& id,
+                     const std::string& method,
+                     const JsonValue& params);
+
+  void HandleNotification(const std::string& method,
+                          const JsonValue& params);
+
+  void OpenDocument(const std::string& uri, const std::string& text);
+
+  void ChangeDocument(const std::string& uri, const JsonValue& changes);
+
+  void CloseDocument(const std::string& uri);
+
+  // Replace [begin, end) of the document text and re-split and re-check
+  // the statements it touches
+  void EditDocument(LspDocument& document,
+                    const size_t begin,
+                    const size_t end,
+                    const std::string& text);
+
+  void CheckDocumentStatement(const LspDocument& document,
+                              LspStatement& statement);
+
+  void BuildDiagnostics(const LspDocument& document, LspStatement& statement);
+
+  void PublishDiagnostics(const std::string& uri, LspDocument& document);
+
+  void SendMessage(const std::string& body);
+
+  // configuration
+  Configuration& state_;
+
+  // output stream
+  std::ostream& output_;
+
+  // open documents by uri
+  std::map<std::string, LspDocument> documents_;
+
+  // shutdown requested
+  bool shutdown_;
+
+  // statements checked
+  size_t checked_statement_count_;
+
+};
+
+// Serve the Language Server Protocol over the given streams
+int RunLspServer(Configuration& state,
+                 std::istream& input,
+                 std::ostream& output);
+
+}  // namespace sqlcheck
@@ -0,0 +1,62 @@
+// MATCHER HEADER
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+
+#include "patterns.h"
+
+namespace sqlcheck {
+
+// Whether a text has a match of a built-in pattern, decided in one pass by
+// the state machine generated for the pattern when sqlcheck is built
+// (matchers.cpp, written by sqlcheck_generate_matchers). True for the
+// patterns the generator does not support.
+bool MatchPattern(const PatternId pattern, const char* data, const size_t size);
+
+// Built-in patterns that may have a match in a text. Built with Hyperscan
+// (or Vectorscan), one pass over the text with a database of all the
+// built-in patterns rules out the others; otherwise none is ruled out.
+PatternSet ScanPatterns(const std::string& text);
+
+// Pattern of a rule. A built-in pattern first runs its generated state
+// machine, so that its regex (compiled on the first match) runs on the
+// statements with a match alone. Other patterns run their regex only.
+class Matcher {
+
+ public:
+  explicit Matcher(const PatternId pattern);
+
+  Matcher(const std::string& pattern,
+          const std::regex::flag_type flags = std::regex::ECMAScript);
+
+  // False if the statement has no match, true if it may have some.
+  // Built-in patterns out of candidates (from ScanPatterns) have none.
+  bool MayMatch(const std::string& statement,
+                const PatternSet candidates = kAllPatterns) const;
+
+  // Regex of the pattern, to find where it matches
+  const std::regex& GetRegex() const;
+
+  Matcher(const Matcher&) = delete;
+  Matcher& operator=(const Matcher&) = delete;
+
+ private:
+
+  bool built_in_;
+
+  PatternId pattern_;
+
+  // pattern of the regex, folded for built-in patterns
+  std::string text_;
+  std::regex::flag_type flags_;
+
+  mutable std::once_flag regex_once_;
+  mutable std::unique_ptr<std::regex> regex_;
+
+};
+
+}  // namespace sqlcheck
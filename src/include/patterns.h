@@ -0,0 +1,47 @@
+// PATTERNS HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace sqlcheck {
+
+// Patterns of the built-in rules (patterns.def)
+enum PatternId : std::uint8_t {
+
+#define SQLCHECK_PATTERN(identifier, pattern) PATTERN_##identifier,
+#include "patterns.def"
+#undef SQLCHECK_PATTERN
+
+};
+
+const size_t kPatternCount =
+#define SQLCHECK_PATTERN(identifier, pattern) 1 +
+#include "patterns.def"
+#undef SQLCHECK_PATTERN
+    0;
+
+// Set of built-in patterns, one bit for each
+typedef std::uint64_t PatternSet;
+
+static_assert(kPatternCount <= 64, "a PatternSet has a bit for each pattern");
+
+const PatternSet kAllPatterns = ~static_cast<PatternSet>(0);
+
+inline PatternSet GetPatternBit(const PatternId pattern){
+  return static_cast<PatternSet>(1) << pattern;
+}
+
+// Identifier of a built-in pattern (SELECT_STAR, for example)
+const char* GetPatternName(const PatternId pattern);
+
+// Built-in pattern, in lower case
+const char* GetPatternText(const PatternId pattern);
+
+// Rewrite a pattern written with lower case letters to match either case,
+// so that statements are matched in their original case:
+//   (group by)  ->  ([gG][rR][oO][uU][pP] [bB][yY])
+std::string FoldPatternCase(const std::string& pattern);
+
+}  // namespace sqlcheck
@@ -0,0 +1,88 @@
+// PERF COUNTERS HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+enum PerfCounter {
+  PERF_COUNTER_TASK_CLOCK = 0,
+  PERF_COUNTER_CYCLES = 1,
+  PERF_COUNTER_INSTRUCTIONS = 2,
+  PERF_COUNTER_BRANCH_MISSES = 3,
+  PERF_COUNTER_LLC_MISSES = 4,
+
+  PERF_COUNTER_COUNT = 5
+};
+
+std::string PerfCounterToString(const PerfCounter& counter);
+
+// Counter values of a thread, or the counts of a slot
+struct PerfCounts {
+
+  PerfCounts()
+   : values(),
+     sample_count(0) {
+  }
+
+  std::uint64_t values[PERF_COUNTER_COUNT];
+
+  // samples added to a slot
+  std::uint64_t sample_count;
+
+};
+
+// Whether counts are recorded, only changed while no other thread runs
+extern bool perf_counters_enabled;
+
+// Start counting in slot_count slots, returns false with the reason if the
+// kernel does not count for this process (no perf_event_open, paranoid
+// setting, seccomp)
+bool StartPerfCounters(const size_t slot_count, std::string& error);
+
+// Stop counting and sum the slots of every thread, available[counter] is
+// false for the counters the hardware does not provide (virtual machines)
+void StopPerfCounters(std::vector<PerfCounts>& slot_counts,
+                      bool available[PERF_COUNTER_COUNT]);
+
+// Read the counters of the calling thread, opened on first use
+void ReadPerfCounters(PerfCounts& counts);
+
+// Add the counts between two reads of the calling thread to a slot
+void AddPerfCounts(const size_t slot,
+                   const PerfCounts& start,
+                   const PerfCounts& end,
+                   const std::uint64_t sample_count = 1);
+
+// Adds the counts of a scope of the calling thread to a slot
+class PerfCounterScope {
+
+ public:
+  explicit PerfCounterScope(const size_t slot)
+   : slot_(slot) {
+    if (perf_counters_enabled) {
+      ReadPerfCounters(start_);
+    }
+  }
+
+  ~PerfCounterScope() {
+    if (perf_counters_enabled) {
+      PerfCounts end;
+      ReadPerfCounters(end);
+      AddPerfCounts(slot_, start_, end);
+    }
+  }
+
+  PerfCounterScope(const PerfCounterScope&) = delete;
+  PerfCounterScope& operator=(const PerfCounterScope&) = delete;
+
+ private:
+  const size_t slot_;
+  PerfCounts start_;
+
+};
+
+}  // namespace sqlcheck
@@ -0,0 +1,16 @@
+// PIPELINE HEADER
+
+#pragma once
+
+#include <ostream>
+
+#include "configuration.h"
+
+namespace sqlcheck {
+
+// Check the input of the configuration with concurrent stages: a reader, a
+// splitter, state.thread_count work-stealing checkers and a writer that
+// prints the findings to the output in statement order
+void RunPipeline(Configuration& state, std::ostream& output);
+
+}  // namespace sqlcheck
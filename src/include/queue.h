@@ -0,0 +1,149 @@
+// QUEUE HEADER
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace sqlcheck {
+
+// Spin, then yield, then sleep while waiting on a queue (spinning only
+// delays the other thread on a single core)
+inline void QueueBackoff(size_t& attempts){
+  static const bool spin = std::thread::hardware_concurrency() > 1;
+  attempts++;
+  if (attempts < 64 && spin) {
+    return;
+  }
+  if (attempts < 1024) {
+    std::this_thread::yield();
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+// Bounded lock-free multi-producer multi-consumer queue
+// (D. Vyukov's array-based design, one sequence number per cell)
+template <typename T>
+class BoundedQueue {
+
+ public:
+  explicit BoundedQueue(size_t capacity)
+ : capacity_(RoundUpToPowerOfTwo(capacity)),
+   mask_(capacity_ - 1),
+   cells_(new Cell[capacity_]),
+   enqueue_position_(0),
+   dequeue_position_(0){
+    for (size_t i = 0; i < capacity_; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Returns false if the queue is full
+  bool TryPush(T& value) {
+    auto position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& cell = cells_[position & mask_];
+      auto sequence = cell.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::ptrdiff_t>(sequence) -
+          static_cast<std::ptrdiff_t>(position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                    std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0) {
+        return false;
+      }
+      else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the queue is empty
+  bool TryPop(T& value) {
+    auto position = dequeue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& cell = cells_[position & mask_];
+      auto sequence = cell.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::ptrdiff_t>(sequence) -
+          static_cast<std::ptrdiff_t>(position + 1);
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(position, position + 1,
+                                                    std::memory_order_relaxed)) {
+          value = std::move(cell.value);
+          cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0) {
+        return false;
+      }
+      else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Block while the queue is full (backpressure)
+  void Push(T value) {
+    size_t attempts = 0;
+    while (TryPush(value) == false) {
+      QueueBackoff(attempts);
+    }
+  }
+
+  // Block while the queue is empty
+  void Pop(T& value) {
+    size_t attempts = 0;
+    while (TryPop(value) == false) {
+      QueueBackoff(attempts);
+    }
+  }
+
+  size_t GetCapacity() const { return capacity_; }
+
+ private:
+
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t power = 2;
+    while (power < value) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  // capacity (power of two)
+  const size_t capacity_;
+
+  // capacity - 1
+  const size_t mask_;
+
+  // cells
+  std::unique_ptr<Cell[]> cells_;
+
+  // next position to push, on its own cache line
+  alignas(64) std::atomic<size_t> enqueue_position_;
+
+  // next position to pop, on its own cache line
+  alignas(64) std::atomic<size_t> dequeue_position_;
+
+};
+
+}  // namespace sqlcheck
@@ -0,0 +1,54 @@
+// READER HEADER
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+// Contents of an input file
+struct FileData {
+
+  FileData()
+   : index(0),
+     error(0) {
+  }
+
+  // index of the file in the list of files
+  size_t index;
+
+  std::string data;
+
+  // errno of the failed open or read (0 on success)
+  int error;
+
+};
+
+// Reads a list of files, keeping several reads in flight, and hands them
+// out in list order
+class FileReader {
+
+ public:
+  virtual ~FileReader() {}
+
+  // Wait for the next file in list order, returns false after the last file
+  virtual bool Next(FileData& file) = 0;
+
+};
+
+// Reader backed by io_uring when the kernel supports it (and use_io_uring
+// is set) and by a pool of pread threads otherwise, with at most
+// queue_depth files in flight
+std::unique_ptr<FileReader> OpenFileReader(const std::vector<std::string>& file_names,
+                                           const size_t queue_depth,
+                                           const bool use_io_uring = true);
+
+// Append the path, or the .sql files below it in path order if it is a
+// directory (without following links to directories), returns false if the
+// path does not exist
+bool CollectInputFiles(const std::string& path,
+                       std::vector<std::string>& file_names);
+
+}  // namespace sqlcheck
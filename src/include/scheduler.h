@@ -0,0 +1,84 @@
+// SCHEDULER HEADER
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sqlcheck {
+
+// Work-stealing task scheduler: each worker runs the newest task spawned on
+// it, then its oldest submitted task and, once it runs dry, steals the oldest
+// task of another worker. Submitted tasks thus start in submission order.
+// Without workers, tasks run on the thread submitting or spawning them.
+class TaskScheduler {
+
+ public:
+  // Task, invoked with the index of the worker running it
+  typedef std::function<void(size_t worker)> Task;
+
+  explicit TaskScheduler(size_t worker_count);
+
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  // Submit a task from outside the workers (round robin over the deques)
+  void Submit(Task task);
+
+  // Spawn a task from a running task onto the deque of its worker
+  void Spawn(size_t worker, Task task);
+
+  // Run the remaining tasks and stop the workers
+  void Finish();
+
+  size_t GetWorkerCount() const { return queues_.size(); }
+
+  // Number of tasks run by another worker than the one they were queued on
+  size_t GetStealCount() const { return steal_count_.load(); }
+
+ private:
+
+  struct WorkerQueue {
+    std::mutex mutex;
+
+    // tasks submitted, taken first in first out
+    std::deque<Task> submitted_tasks;
+
+    // tasks spawned by running tasks, taken last in first out by the worker
+    std::deque<Task> spawned_tasks;
+  };
+
+  void Push(size_t worker, Task task, const bool spawned);
+
+  bool TakeTask(size_t worker, Task& task);
+
+  void RunWorker(size_t worker);
+
+  // deque of each worker
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+
+  // worker threads
+  std::vector<std::thread> threads_;
+
+  // tasks queued or running
+  std::atomic<size_t> pending_task_count_;
+
+  // no more tasks are submitted
+  std::atomic<bool> finishing_;
+
+  // deque of the next submitted task
+  std::atomic<size_t> next_queue_;
+
+  // stolen tasks
+  std::atomic<size_t> steal_count_;
+
+};
+
+}  // namespace sqlcheck
@@ -0,0 +1,84 @@
+// SPLITTER HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace sqlcheck {
+
+// Lexical state of the splitter between two bytes
+enum SplitState {
+  SPLIT_STATE_NORMAL = 0,
+
+  // after '-' or '/', which may start a comment
+  SPLIT_STATE_DASH = 1,
+  SPLIT_STATE_SLASH = 2,
+
+  // in a quoted string or identifier, or after a backslash in it (only with
+  // backslash escapes)
+  SPLIT_STATE_SINGLE_QUOTE = 3,
+  SPLIT_STATE_SINGLE_QUOTE_ESCAPE = 4,
+  SPLIT_STATE_DOUBLE_QUOTE = 5,
+  SPLIT_STATE_DOUBLE_QUOTE_ESCAPE = 6,
+  SPLIT_STATE_BACKTICK = 7,
+
+  // in a comment, or after '*' in a block comment
+  SPLIT_STATE_LINE_COMMENT = 8,
+  SPLIT_STATE_BLOCK_COMMENT = 9,
+  SPLIT_STATE_BLOCK_COMMENT_STAR = 10,
+
+  SPLIT_STATE_COUNT = 11
+};
+
+// Delimiter that ends a statement
+struct SplitDelimiter {
+
+  // offset of the delimiter in the scanned bytes
+  size_t offset;
+
+  // line breaks before the delimiter in the scanned bytes
+  std::uint32_t line;
+
+};
+
+// Finds the delimiters that are not in a string, identifier or comment.
+// Quotes are escaped by doubling them, and also by a backslash with
+// backslash_escapes (MySQL).
+class SplitMachine {
+
+ public:
+  SplitMachine(const char delimiter, const bool backslash_escapes);
+
+  // Scan bytes from a state, append their delimiters and count their lines
+  SplitState Scan(const char* data,
+                  const size_t size,
+                  const SplitState state,
+                  std::vector<SplitDelimiter>& delimiters,
+                  std::uint32_t& line_count) const;
+
+  // State after scanning bytes from each possible state
+  void ScanTransitions(const char* data,
+                       const size_t size,
+                       SplitState end_states[SPLIT_STATE_COUNT]) const;
+
+ private:
+
+  // next state of each state and byte, with kDelimiterBit set on delimiters
+  std::uint8_t transitions_[SPLIT_STATE_COUNT][256];
+
+};
+
+// Find the delimiters of the bytes with up to thread_count threads: the
+// chunk of each thread is first scanned from every state, the states at the
+// chunk boundaries are then resolved in order and each chunk is rescanned
+// from its actual state
+SplitState FindDelimiters(const SplitMachine& machine,
+                          const char* data,
+                          const size_t size,
+                          const SplitState state,
+                          const size_t thread_count,
+                          std::vector<SplitDelimiter>& delimiters,
+                          std::uint32_t& line_count);
+
+}  // namespace sqlcheck
@@ -0,0 +1,69 @@
+// STATS HEADER
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sqlcheck {
+
+// Robust summary of repeated measurements
+struct SampleSummary {
+
+  SampleSummary()
+   : count(0),
+     median(0),
+     mad(0),
+     ci_low(0),
+     ci_high(0) {
+  }
+
+  size_t count;
+
+  double median;
+
+  // median absolute deviation from the median
+  double mad;
+
+  // distribution-free 95% confidence interval of the median
+  double ci_low;
+  double ci_high;
+
+};
+
+SampleSummary SummarizeSamples(std::vector<double> samples);
+
+enum ComparisonResult {
+  COMPARISON_UNCHANGED = 0,
+  COMPARISON_FASTER = 1,
+  COMPARISON_SLOWER = 2
+};
+
+std::string ComparisonResultToString(const ComparisonResult& result);
+
+// Change of the median of a benchmark between two runs
+struct SampleComparison {
+
+  SampleComparison()
+   : change(0),
+     result(COMPARISON_UNCHANGED) {
+  }
+
+  SampleSummary baseline;
+
+  SampleSummary current;
+
+  // relative change of the median (0.1 is 10% slower)
+  double change;
+
+  // slower or faster when the change is beyond the threshold and the
+  // confidence intervals of the medians do not overlap
+  ComparisonResult result;
+
+};
+
+SampleComparison CompareSamples(const std::vector<double>& baseline,
+                                const std::vector<double>& current,
+                                const double threshold);
+
+}  // namespace sqlcheck
@@ -0,0 +1,59 @@
+// TRACE HEADER
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace sqlcheck {
+
+// Whether spans are recorded, only changed while no other thread runs
+extern bool trace_enabled;
+
+// Start recording spans, dropping the spans of a previous trace
+void StartTrace();
+
+// Stop recording and write the spans as Chrome trace-event JSON (viewable
+// in Perfetto or chrome://tracing), returns false if the file cannot be written
+bool WriteTrace(const std::string& file_name);
+
+// Nanoseconds since the trace started
+std::int64_t GetTraceTime();
+
+// Record a span of the calling thread, in its own buffer
+void RecordTraceSpan(const char* name,
+                     const char* category,
+                     const std::int64_t start,
+                     const std::int64_t end);
+
+// Name the calling thread in the trace
+void SetTraceThreadName(const std::string& name);
+
+// Records the lifetime of a scope as a span of the calling thread, the name
+// and category must outlive the trace
+class TraceSpan {
+
+ public:
+  explicit TraceSpan(const char* name, const char* category = "stage")
+   : name_(name),
+     category_(category),
+     start_(trace_enabled ? GetTraceTime() : 0) {
+  }
+
+  ~TraceSpan() {
+    if (trace_enabled) {
+      RecordTraceSpan(name_, category_, start_, GetTraceTime());
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name_;
+  const char* category_;
+  const std::int64_t start_;
+
+};
+
+}  // namespace sqlcheck
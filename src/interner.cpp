@@ -0,0 +1,228 @@
+// INTERNER SOURCE
+
+#include <cstring>
+
+#include "include/interner.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Bytes of an arena block, longer texts get a block of their own
+const size_t kArenaBlockSize = 64 << 10;
+
+const size_t kInitialSlotCount = 1024;
+
+const std::uint64_t kHashSecret[4] = {
+  0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+// 128-bit product of a and b, folded to 64 bits
+std::uint64_t Mix(const std::uint64_t a, const std::uint64_t b){
+  auto product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+}
+
+std::uint64_t Read8(const unsigned char* data){
+  std::uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+std::uint64_t Read4(const unsigned char* data){
+  std::uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+std::uint64_t Read3(const unsigned char* data, const size_t size){
+  return (static_cast<std::uint64_t>(data[0]) << 16) |
+      (static_cast<std::uint64_t>(data[size >> 1]) << 8) | data[size - 1];
+}
+
+}  // namespace
+
+std::uint64_t HashString(const char* text, const size_t size){
+  auto data = reinterpret_cast<const unsigned char*>(text);
+  std::uint64_t seed = Mix(kHashSecret[0], kHashSecret[1]);
+  std::uint64_t a, b;
+
+  if (size <= 16) {
+    if (size >= 4) {
+      auto middle = (size >> 3) << 2;
+      a = (Read4(data) << 32) | Read4(data + middle);
+      b = (Read4(data + size - 4) << 32) | Read4(data + size - 4 - middle);
+    }
+    else if (size > 0) {
+      a = Read3(data, size);
+      b = 0;
+    }
+    else {
+      a = b = 0;
+    }
+  }
+  else {
+    auto remaining = size;
+    if (remaining > 48) {
+      auto seed1 = seed, seed2 = seed;
+      do {
+        seed = Mix(Read8(data) ^ kHashSecret[1], Read8(data + 8) ^ seed);
+        seed1 = Mix(Read8(data + 16) ^ kHashSecret[2], Read8(data + 24) ^ seed1);
+        seed2 = Mix(Read8(data + 32) ^ kHashSecret[3], Read8(data + 40) ^ seed2);
+        data += 48;
+        remaining -= 48;
+      } while (remaining > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (remaining > 16) {
+      seed = Mix(Read8(data) ^ kHashSecret[1], Read8(data + 8) ^ seed);
+      data += 16;
+      remaining -= 16;
+    }
+    a = Read8(data + remaining - 16);
+    b = Read8(data + remaining - 8);
+  }
+
+  a ^= kHashSecret[1];
+  b ^= seed;
+  auto product = static_cast<unsigned __int128>(a) * b;
+  a = static_cast<std::uint64_t>(product);
+  b = static_cast<std::uint64_t>(product >> 64);
+  return Mix(a ^ kHashSecret[0] ^ size, b ^ kHashSecret[1]);
+}
+
+StringInterner::StringInterner(){
+  Clear();
+}
+
+StringId StringInterner::Intern(const std::string& text){
+  if (text.empty()) {
+    return kNoStringId;
+  }
+
+  auto hash = HashString(text.data(), text.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto slot = FindSlot(text.data(), text.size(), hash);
+  if (slots_[slot] != kNoStringId) {
+    return slots_[slot];
+  }
+
+  Entry entry;
+  entry.data = Store(text.data(), text.size());
+  entry.size = static_cast<std::uint32_t>(text.size());
+  entry.hash = hash;
+  auto id = static_cast<StringId>(entries_.size());
+  entries_.push_back(entry);
+  slots_[slot] = id;
+
+  // Keep the table at most half full
+  if (entries_.size() * 2 > slots_.size()) {
+    Grow();
+  }
+  return id;
+}
+
+StringId StringInterner::Find(const std::string& text){
+  if (text.empty()) {
+    return kNoStringId;
+  }
+
+  auto hash = HashString(text.data(), text.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slots_[FindSlot(text.data(), text.size(), hash)];
+}
+
+const char* StringInterner::GetData(const StringId id){
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_[id].data;
+}
+
+size_t StringInterner::GetSize(const StringId id){
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_[id].size;
+}
+
+std::string StringInterner::GetString(const StringId id){
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto& entry = entries_[id];
+  return std::string(entry.data, entry.size);
+}
+
+size_t StringInterner::GetCount(){
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size() - 1;
+}
+
+size_t StringInterner::GetMemoryUsage(){
+  std::lock_guard<std::mutex> lock(mutex_);
+  return arena_size_ + entries_.capacity() * sizeof(Entry) +
+      slots_.capacity() * sizeof(StringId);
+}
+
+void StringInterner::Clear(){
+  std::lock_guard<std::mutex> lock(mutex_);
+  blocks_.clear();
+  block_used_ = 0;
+  block_size_ = 0;
+  arena_size_ = 0;
+
+  Entry no_entry;
+  no_entry.data = "";
+  no_entry.size = 0;
+  no_entry.hash = 0;
+  entries_.assign(1, no_entry);
+  slots_.assign(kInitialSlotCount, kNoStringId);
+}
+
+size_t StringInterner::FindSlot(const char* data, const size_t size,
+                                const std::uint64_t hash) const {
+  auto mask = slots_.size() - 1;
+  auto slot = static_cast<size_t>(hash) & mask;
+  while (slots_[slot] != kNoStringId) {
+    const auto& entry = entries_[slots_[slot]];
+    if (entry.hash == hash && entry.size == size && memcmp(entry.data, data, size) == 0) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+const char* StringInterner::Store(const char* data, const size_t size){
+  auto needed = size + 1;
+  if (block_used_ + needed > block_size_) {
+    auto block_size = needed > kArenaBlockSize ? needed : kArenaBlockSize;
+    blocks_.emplace_back(new char[block_size]);
+    block_used_ = 0;
+    block_size_ = block_size;
+    arena_size_ += block_size;
+  }
+
+  auto copy = blocks_.back().get() + block_used_;
+  memcpy(copy, data, size);
+  copy[size] = '\0';
+  block_used_ += needed;
+  return copy;
+}
+
+void StringInterner::Grow(){
+  std::vector<StringId> slots(slots_.size() * 2, kNoStringId);
+  auto mask = slots.size() - 1;
+  for (StringId id = 1; id < entries_.size(); id++) {
+    auto slot = static_cast<size_t>(entries_[id].hash) & mask;
+    while (slots[slot] != kNoStringId) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = id;
+  }
+  slots_.swap(slots);
+}
+
+StringInterner& GetInterner(){
+  static StringInterner interner;
+  return interner;
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,373 @@
+// JSON SOURCE
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "include/json.h"
+
+namespace sqlcheck {
+
+namespace {
+
+class JsonParser {
+
+ public:
+  JsonParser(const std::string& text)
+ : text_(text),
+   position_(0){
+  }
+
+  bool Parse(JsonValue& value) {
+    if (ParseValue(value, 0) == false) {
+      return false;
+    }
+    SkipSpace();
+    return position_ == text_.size();
+  }
+
+ private:
+
+  void SkipSpace() {
+    while (position_ < text_.size() &&
+        (text_[position_] == ' ' || text_[position_] == '\t' ||
+         text_[position_] == '\r' || text_[position_] == '\n')) {
+      position_++;
+    }
+  }
+
+  bool Consume(const char* literal) {
+    size_t i = 0;
+    while (literal[i] != '\0') {
+      if (position_ + i >= text_.size() || text_[position_ + i] != literal[i]) {
+        return false;
+      }
+      i++;
+    }
+    position_ += i;
+    return true;
+  }
+
+  bool ParseValue(JsonValue& value, const size_t depth) {
+
+    // Guard against stack exhaustion on hostile input
+    if (depth > 256) {
+      return false;
+    }
+
+    SkipSpace();
+    if (position_ >= text_.size()) {
+      return false;
+    }
+
+    switch (text_[position_]) {
+      case '{':
+        return ParseObject(value, depth);
+      case '[':
+        return ParseArray(value, depth);
+      case '"':
+        value.type = JSON_TYPE_STRING;
+        return ParseString(value.string);
+      case 't':
+        value.type = JSON_TYPE_BOOL;
+        value.boolean = true;
+        return Consume("true");
+      case 'f':
+        value.type = JSON_TYPE_BOOL;
+        value.boolean = false;
+        return Consume("false");
+      case 'n':
+        value.type = JSON_TYPE_NULL;
+        return Consume("null");
+      default:
+        return ParseNumber(value);
+    }
+  }
+
+  bool ParseObject(JsonValue& value, const size_t depth) {
+
+    value.type = JSON_TYPE_OBJECT;
+    position_++;
+
+    SkipSpace();
+    if (position_ < text_.size() && text_[position_] == '}') {
+      position_++;
+      return true;
+    }
+
+    while (true) {
+      SkipSpace();
+      std::string key;
+      if (position_ >= text_.size() || text_[position_] != '"' ||
+          ParseString(key) == false) {
+        return false;
+      }
+
+      SkipSpace();
+      if (Consume(":") == false) {
+        return false;
+      }
+
+      if (ParseValue(value.object[key], depth + 1) == false) {
+        return false;
+      }
+
+      SkipSpace();
+      if (Consume(",")) {
+        continue;
+      }
+      return Consume("}");
+    }
+  }
+
+  bool ParseArray(JsonValue& value, const size_t depth) {
+
+    value.type = JSON_TYPE_ARRAY;
+    position_++;
+
+    SkipSpace();
+    if (position_ < text_.size() && text_[position_] == ']') {
+      position_++;
+      return true;
+    }
+
+    while (true) {
+      value.array.push_back(JsonValue());
+      if (ParseValue(value.array.back(), depth + 1) == false) {
+        return false;
+      }
+
+      SkipSpace();
+      if (Consume(",")) {
+        continue;
+      }
+      return Consume("]");
+    }
+  }
+
+  bool ParseNumber(JsonValue& value) {
+
+    const char* begin = text_.c_str() + position_;
+    char* end = nullptr;
+    value.type = JSON_TYPE_NUMBER;
+    value.number = std::strtod(begin, &end);
+    if (end == begin) {
+      return false;
+    }
+
+    position_ += end - begin;
+    return true;
+  }
+
+  bool ParseHex(unsigned int& code_unit) {
+    if (position_ + 4 > text_.size()) {
+      return false;
+    }
+    code_unit = 0;
+    for (size_t i = 0; i < 4; i++) {
+      char c = text_[position_++];
+      code_unit <<= 4;
+      if (c >= '0' && c <= '9') {
+        code_unit |= c - '0';
+      }
+      else if (c >= 'a' && c <= 'f') {
+        code_unit |= c - 'a' + 10;
+      }
+      else if (c >= 'A' && c <= 'F') {
+        code_unit |= c - 'A' + 10;
+      }
+      else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void AppendUtf8(std::string& str, const unsigned int code_point) {
+    if (code_point < 0x80) {
+      str += static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800) {
+      str += static_cast<char>(0xC0 | (code_point >> 6));
+      str += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000) {
+      str += static_cast<char>(0xE0 | (code_point >> 12));
+      str += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      str += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else {
+      str += static_cast<char>(0xF0 | (code_point >> 18));
+      str += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      str += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      str += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  bool ParseString(std::string& str) {
+
+    // Skip opening quote
+    position_++;
+
+    while (position_ < text_.size()) {
+      char c = text_[position_++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        str += c;
+        continue;
+      }
+
+      if (position_ >= text_.size()) {
+        return false;
+      }
+
+      char escape = text_[position_++];
+      switch (escape) {
+        case '"': str += '"'; break;
+        case '\\': str += '\\'; break;
+        case '/': str += '/'; break;
+        case 'b': str += '\b'; break;
+        case 'f': str += '\f'; break;
+        case 'n': str += '\n'; break;
+        case 'r': str += '\r'; break;
+        case 't': str += '\t'; break;
+        case 'u': {
+          unsigned int code_point = 0;
+          if (ParseHex(code_point) == false) {
+            return false;
+          }
+          // Combine UTF-16 surrogate pairs
+          if (code_point >= 0xD800 && code_point < 0xDC00 &&
+              Consume("\\u")) {
+            unsigned int low = 0;
+            if (ParseHex(low) == false || low < 0xDC00 || low > 0xDFFF) {
+              return false;
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          }
+          AppendUtf8(str, code_point);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+
+    return false;
+  }
+
+  // text
+  const std::string& text_;
+
+  // position in text
+  size_t position_;
+
+};
+
+void AppendJson(std::string& output, const JsonValue& value) {
+
+  switch (value.type) {
+    case JSON_TYPE_BOOL:
+      output += value.boolean ? "true" : "false";
+      break;
+    case JSON_TYPE_NUMBER: {
+      char buffer[32];
+      if (value.number == std::floor(value.number) && std::fabs(value.number) < 1e15) {
+        snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value.number));
+      }
+      else {
+        snprintf(buffer, sizeof(buffer), "%.17g", value.number);
+      }
+      output += buffer;
+      break;
+    }
+    case JSON_TYPE_STRING:
+      AppendJsonString(output, value.string);
+      break;
+    case JSON_TYPE_ARRAY:
+      output += '[';
+      for (size_t i = 0; i < value.array.size(); i++) {
+        if (i > 0) {
+          output += ',';
+        }
+        AppendJson(output, value.array[i]);
+      }
+      output += ']';
+      break;
+    case JSON_TYPE_OBJECT: {
+      output += '{';
+      bool first = true;
+      for (const auto& member : value.object) {
+        if (first == false) {
+          output += ',';
+        }
+        first = false;
+        AppendJsonString(output, member.first);
+        output += ':';
+        AppendJson(output, member.second);
+      }
+      output += '}';
+      break;
+    }
+    case JSON_TYPE_NULL:
+    default:
+      output += "null";
+      break;
+  }
+
+}
+
+}  // namespace
+
+const JsonValue& JsonValue::Get(const std::string& key) const {
+
+  static const JsonValue null_value;
+
+  auto member = object.find(key);
+  if (member == object.end()) {
+    return null_value;
+  }
+  return member->second;
+}
+
+bool ParseJson(const std::string& text, JsonValue& value) {
+  JsonParser parser(text);
+  return parser.Parse(value);
+}
+
+std::string ToJson(const JsonValue& value) {
+  std::string output;
+  AppendJson(output, value);
+  return output;
+}
+
+void AppendJsonString(std::string& output, const std::string& str) {
+
+  static const char hex_digits[] = "0123456789abcdef";
+
+  output += '"';
+  for (auto c : str) {
+    switch (c) {
+      case '"': output += "\\\""; break;
+      case '\\': output += "\\\\"; break;
+      case '\n': output += "\\n"; break;
+      case '\r': output += "\\r"; break;
+      case '\t': output += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          output += "\\u00";
+          output += hex_digits[(c >> 4) & 0xF];
+          output += hex_digits[c & 0xF];
+        }
+        else {
+          output += c;
+        }
+    }
+  }
+  output += '"';
+
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,217 @@
+// LEXER SOURCE
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "include/lexer.h"
+
+namespace sqlcheck {
+
+namespace {
+
+struct KeywordName {
+
+  const char* text;
+  size_t size;
+
+};
+
+// Text of each keyword, indexed by Keyword
+const KeywordName kKeywordNames[kKeywordCount] = {
+  {"", 0},
+#define SQLCHECK_KEYWORD(identifier, text) {text, sizeof(text) - 1},
+#include "include/keywords.def"
+#undef SQLCHECK_KEYWORD
+};
+
+const size_t kMinKeywordSize = 2;
+const size_t kMaxKeywordSize = 17;
+
+bool IsWordStart(const char c){
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool IsWordCharacter(const char c){
+  return IsWordStart(c) || (c >= '0' && c <= '9') || c == '$';
+}
+
+// Offset after the word or number starting at position
+size_t SkipWord(const std::string& text, size_t position){
+  while (position < text.size() && IsWordCharacter(text[position])) {
+    position++;
+  }
+  return position;
+}
+
+}  // namespace
+
+Keyword LookupKeyword(const char* data, const size_t size){
+  if (size < kMinKeywordSize || size > kMaxKeywordSize) {
+    return KEYWORD_NONE;
+  }
+
+  // Words are looked up in either case
+  auto slot = GetKeywordSlot(GetKeywordKey(data, size), kKeywordHashMultiplier);
+  auto keyword = static_cast<Keyword>(kKeywordSlots[slot]);
+
+  const auto& name = kKeywordNames[keyword];
+  if (name.size != size) {
+    return KEYWORD_NONE;
+  }
+  for (size_t i = 0; i < size; i++) {
+    if (FoldKeywordCase(static_cast<unsigned char>(data[i])) !=
+        static_cast<unsigned char>(name.text[i])) {
+      return KEYWORD_NONE;
+    }
+  }
+  return keyword;
+}
+
+const char* GetKeywordName(const Keyword keyword){
+  return kKeywordNames[keyword].text;
+}
+
+namespace {
+
+// Add the keywords of the words between two offsets (the end of the text
+// with npos) to a set
+void AddKeywords(const std::string& text, size_t position, size_t end,
+                 KeywordSet& keyword_set){
+  end = std::min(end, text.size());
+  while (position < end) {
+    auto c = text[position];
+    if (IsWordCharacter(c)) {
+      auto start = position;
+      position = SkipWord(text, position);
+      if (IsWordStart(c)) {
+        auto keyword = LookupKeyword(text.data() + start, position - start);
+        if (keyword != KEYWORD_NONE) {
+          keyword_set.Add(keyword);
+        }
+      }
+    }
+    else {
+      position++;
+    }
+  }
+}
+
+}  // namespace
+
+void LexKeywords(const std::string& statement, std::vector<Keyword>& keywords,
+                 KeywordSet& keyword_set){
+  keywords.clear();
+  keyword_set = KeywordSet();
+
+  size_t position = 0;
+  while (position < statement.size()) {
+    auto c = statement[position];
+    auto start = position;
+
+    if (c == '\'' || c == '"' || c == '`') {
+      position = SkipQuotedText(statement, position);
+      AddKeywords(statement, start, position, keyword_set);
+    }
+    else if (c == '-' && statement.compare(position, 2, "--") == 0) {
+      position = statement.find('\n', position);
+      AddKeywords(statement, start, position, keyword_set);
+    }
+    else if (c == '/' && statement.compare(position, 2, "/*") == 0) {
+      position = statement.find("*/", position + 2);
+      if (position != std::string::npos) {
+        position += 2;
+      }
+      AddKeywords(statement, start, position, keyword_set);
+    }
+    else if (IsWordCharacter(c)) {
+      position = SkipWord(statement, position);
+      if (IsWordStart(c)) {
+        auto keyword = LookupKeyword(statement.data() + start, position - start);
+        if (keyword != KEYWORD_NONE) {
+          keywords.push_back(keyword);
+          keyword_set.Add(keyword);
+        }
+      }
+    }
+    else {
+      position++;
+    }
+  }
+}
+
+StatementKind ClassifyStatement(const std::vector<Keyword>& keywords){
+  if (keywords.empty()) {
+    return STATEMENT_KIND_OTHER;
+  }
+
+  switch (keywords[0]) {
+    case KEYWORD_SELECT:
+    case KEYWORD_WITH:
+      return STATEMENT_KIND_SELECT;
+    case KEYWORD_INSERT:
+    case KEYWORD_REPLACE:
+      return STATEMENT_KIND_INSERT;
+    case KEYWORD_UPDATE:
+      return STATEMENT_KIND_UPDATE;
+    case KEYWORD_DELETE:
+      return STATEMENT_KIND_DELETE;
+    case KEYWORD_ALTER:
+      if (keywords.size() > 1 && keywords[1] == KEYWORD_TABLE) {
+        return STATEMENT_KIND_ALTER_TABLE;
+      }
+      return STATEMENT_KIND_OTHER;
+    case KEYWORD_CREATE:
+      break;
+    default:
+      return STATEMENT_KIND_OTHER;
+  }
+
+  // Object created, after modifiers such as temporary, unique or or replace
+  for (size_t i = 1; i < keywords.size(); i++) {
+    switch (keywords[i]) {
+      case KEYWORD_TEMPORARY:
+      case KEYWORD_UNIQUE:
+      case KEYWORD_OR:
+      case KEYWORD_REPLACE:
+        continue;
+      case KEYWORD_TABLE:
+        for (size_t j = i + 1; j + 1 < keywords.size(); j++) {
+          if (keywords[j] == KEYWORD_AS &&
+              (keywords[j + 1] == KEYWORD_SELECT || keywords[j + 1] == KEYWORD_WITH)) {
+            return STATEMENT_KIND_CREATE_TABLE_AS_SELECT;
+          }
+        }
+        return STATEMENT_KIND_CREATE_TABLE;
+      case KEYWORD_INDEX:
+        return STATEMENT_KIND_CREATE_INDEX;
+      default:
+        return STATEMENT_KIND_CREATE_OTHER;
+    }
+  }
+  return STATEMENT_KIND_CREATE_OTHER;
+}
+
+size_t SkipQuotedText(const std::string& text, size_t position){
+  auto quote = text[position++];
+  while (position < text.size()) {
+    auto c = text[position];
+    if (c == '\\') {
+      position += 2;
+    }
+    else if (c == quote) {
+      if (position + 1 < text.size() && text[position + 1] == quote) {
+        position += 2;
+      }
+      else {
+        return position + 1;
+      }
+    }
+    else {
+      position++;
+    }
+  }
+  return std::string::npos;
+}
+
+}  // namespace sqlcheck
@@ -1,6 +1,10 @@
 // LIST SOURCE
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <regex>
+#include <vector>
 
 #include "include/list.h"
 #include "include/checker.h"
@@ -9,17 +13,30 @@ namespace sqlcheck {
 
 // UTILITY
 
+namespace {
+
+// Lower case of an ASCII letter, other characters as they are
+char FoldCase(const char c){
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+}  // namespace
+
 std::string GetTableName(const std::string& sql_statement){
   std::string table_template = "create table";
-  std::size_t found = sql_statement.find(table_template);
-  if (found == std::string::npos) {
+  auto found = std::search(sql_statement.begin(), sql_statement.end(),
+                           table_template.begin(), table_template.end(),
+                           [](const char a, const char b) { return FoldCase(a) == b; }) -
+      sql_statement.begin();
+  if (static_cast<size_t>(found) == sql_statement.size()) {
     return "";
   }
 
   // Locate table name
   auto rest = sql_statement.substr(found + table_template.size());
   // Strip space at beginning
-  rest = std::regex_replace(rest, std::regex("^ +| +$|( ) +"), "$1");
+  static const std::regex space_pattern("^ +| +$|( ) +");
+  rest = std::regex_replace(rest, space_pattern, "$1");
   // check if space or ( comes first in remaining string
   if (rest.find(' ') < rest.find('(')) {
     // space comes first
@@ -28,35 +45,28 @@ std::string GetTableName(const std::string& sql_statement){
     // ( comes first
     rest = rest.substr(0, rest.find('('));
   }
+  // Table names are compared in lower case
   auto table_name = rest;
+  std::transform(table_name.begin(), table_name.end(), table_name.begin(), FoldCase);
 
   return table_name;
 }
 
-bool IsDDLStatement(const std::string& sql_statement){
-  std::string create_table_template = "create table";
-  std::size_t found = sql_statement.find(create_table_template);
-  if (found != std::string::npos) {
-    return true;
-  }
-
-  std::string alter_table_template = "alter table";
-  found = sql_statement.find(alter_table_template);
-  if (found != std::string::npos) {
-    return true;
-  }
-
-  return false;
+StringId GetTableId(const std::string& sql_statement){
+  return GetInterner().Intern(GetTableName(sql_statement));
 }
 
-bool IsCreateStatement(const std::string& sql_statement){
-  std::string create_table_template = "create table";
-  std::size_t found = sql_statement.find(create_table_template);
-  if (found != std::string::npos) {
-    return true;
+// Escape regular expression meta characters in a literal
+std::string EscapeRegex(const std::string& literal){
+  static const std::string meta_characters = "\\^$.|?*+()[]{}";
+  std::string escaped;
+  for (auto c : literal) {
+    if (meta_characters.find(c) != std::string::npos) {
+      escaped += '\\';
+    }
+    escaped += c;
   }
-
-  return false;
+  return escaped;
 }
 
 // LOGICAL DATABASE DESIGN
@@ -66,7 +76,7 @@ void CheckMultiValuedAttribute(Configuration& state,
                                const std::string& sql_statement,
                                bool& print_statement){
 
-  std::regex pattern("(id\\s+varchar)|(id\\s+text)|(id\\s+regexp)");
+  static const Matcher pattern(PATTERN_MULTI_VALUED_ATTRIBUTE);
   std::string title = "Multi-Valued Attribute";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -98,12 +108,15 @@ void CheckRecursiveDependency(Configuration& state,
                               const std::string& sql_statement,
                               bool& print_statement){
 
-  std::string table_name = GetTableName(sql_statement);
-  if(table_name.empty()){
+  if(state.table_name == kNoStringId){
     return;
   }
+  std::string table_name = GetInterner().GetString(state.table_name);
 
-  std::regex pattern("(references\\s+" + table_name+ ")");
+  // Table names in malformed statements may contain meta characters. The
+  // pattern is compiled for each statement, where icase is cheaper than a
+  // folded pattern.
+  Matcher pattern("(references\\s+" + EscapeRegex(table_name) + ")", std::regex::icase);
   std::string title = "Recursive Dependency";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -135,12 +148,7 @@ void CheckPrimaryKeyExists(Configuration& state,
                            const std::string& sql_statement,
                            bool& print_statement){
 
-  auto create_statement = IsCreateStatement(sql_statement);
-  if(create_statement == false){
-    return;
-  }
-
-  std::regex pattern("(primary key)");
+  static const Matcher pattern(PATTERN_PRIMARY_KEY_EXISTS);
   std::string title = "Primary Key Does Not Exist";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -170,12 +178,7 @@ void CheckGenericPrimaryKey(Configuration& state,
                             const std::string& sql_statement,
                             bool& print_statement){
 
-  auto ddl_statement = IsDDLStatement(sql_statement);
-  if(ddl_statement == false){
-    return;
-  }
-
-  std::regex pattern("(\\s+[\\(]?id\\s+)|(,id\\s+)|(\\s+id\\s+serial)");
+  static const Matcher pattern(PATTERN_GENERIC_PRIMARY_KEY);
   std::string title = "Generic Primary Key";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -204,12 +207,7 @@ void CheckForeignKeyExists(Configuration& state,
                            const std::string& sql_statement,
                            bool& print_statement){
 
-  auto create_statement = IsCreateStatement(sql_statement);
-  if(create_statement == false){
-    return;
-  }
-
-  std::regex pattern("(foreign key)");
+  static const Matcher pattern(PATTERN_FOREIGN_KEY_EXISTS);
   std::string title = "Foreign Key Does Not Exist";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -243,17 +241,16 @@ void CheckVariableAttribute(Configuration& state,
                             const std::string& sql_statement,
                             bool& print_statement){
 
-  std::string table_name = GetTableName(sql_statement);
-  if(table_name.empty()){
+  if(state.table_name == kNoStringId){
     return;
   }
 
-  auto found = table_name.find("attribute");
-  if (found == std::string::npos) {
+  // The interned name is compared in place
+  if (strstr(GetInterner().GetData(state.table_name), "attribute") == nullptr) {
     return;
   }
 
-  std::regex pattern("(attribute)");
+  static const Matcher pattern(PATTERN_VARIABLE_ATTRIBUTE);
   std::string title = "Entity-Attribute-Value Pattern";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -299,12 +296,7 @@ void CheckMetadataTribbles(Configuration& state,
                            const std::string& sql_statement,
                            bool& print_statement){
 
-  auto ddl_statement = IsDDLStatement(sql_statement);
-  if(ddl_statement == false){
-    return;
-  }
-
-  std::regex pattern("[A-za-z\\-_@]+[0-9]+ ");
+  static const Matcher pattern(PATTERN_METADATA_TRIBBLES);
   std::string title = "Metadata Tribbles";
   PatternType pattern_type = PatternType::PATTERN_TYPE_LOGICAL_DATABASE_DESIGN;
 
@@ -355,7 +347,7 @@ void CheckFloat(Configuration& state,
                 const std::string& sql_statement,
                 bool& print_statement){
 
-  std::regex pattern("(float)|(real)|(double precision)|(0\\.000[0-9]*)");
+  static const Matcher pattern(PATTERN_FLOAT);
   std::string title = "Imprecise Data Type";
   PatternType pattern_type = PatternType::PATTERN_TYPE_PHYSICAL_DATABASE_DESIGN;
 
@@ -386,12 +378,7 @@ void CheckValuesInDefinition(Configuration& state,
                              const std::string& sql_statement,
                              bool& print_statement){
 
-  auto ddl_statement = IsDDLStatement(sql_statement);
-  if(ddl_statement == false){
-    return;
-  }
-
-  std::regex pattern("( enum)|( in \\()");
+  static const Matcher pattern(PATTERN_VALUES_IN_DEFINITION);
   std::string title = "Values In Definition";
   PatternType pattern_type = PatternType::PATTERN_TYPE_PHYSICAL_DATABASE_DESIGN;
 
@@ -430,7 +417,7 @@ void CheckExternalFiles(Configuration& state,
                         const std::string& sql_statement,
                         bool& print_statement){
 
-  std::regex pattern("(path varchar)|(unlink\\s?\\()");
+  static const Matcher pattern(PATTERN_EXTERNAL_FILES);
   std::string title = "Files Are Not SQL Data Types";
   PatternType pattern_type = PatternType::PATTERN_TYPE_PHYSICAL_DATABASE_DESIGN;
 
@@ -461,13 +448,8 @@ void CheckIndexCount(Configuration& state,
                      const std::string& sql_statement,
                      bool& print_statement){
 
-  auto create_statement = IsCreateStatement(sql_statement);
-  if(create_statement == false){
-    return;
-  }
-
   std::size_t min_count = 3;
-  std::regex pattern("(index)");
+  static const Matcher pattern(PATTERN_INDEX_COUNT);
   std::string title = "Too Many Indexes";
   PatternType pattern_type = PatternType::PATTERN_TYPE_PHYSICAL_DATABASE_DESIGN;
 
@@ -500,7 +482,7 @@ void CheckIndexAttributeOrder(Configuration& state,
                               bool& print_statement){
 
 
-  std::regex pattern("(create index)");
+  static const Matcher pattern(PATTERN_INDEX_ATTRIBUTE_ORDER);
   std::string title = "Index Attribute Order";
   PatternType pattern_type = PatternType::PATTERN_TYPE_PHYSICAL_DATABASE_DESIGN;
 
@@ -533,7 +515,7 @@ void CheckSelectStar(Configuration& state,
                      const std::string& sql_statement,
                      bool& print_statement){
 
-  std::regex pattern("(select\\s+\\*)");
+  static const Matcher pattern(PATTERN_SELECT_STAR);
   std::string title = "SELECT *";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -587,7 +569,7 @@ void CheckSelectStar(Configuration& state,
 void CheckJoinWithoutEquality(Configuration& state,
                               const std::string& sql_statement,
                               bool& print_statement) {
-  std::regex pattern("join[\\s\\._]?[^=]+?(left|right|join|where|case)");
+  static const Matcher pattern(PATTERN_JOIN_WITHOUT_EQUALITY);
   std::string title = "JOIN Without Equality Check";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -610,7 +592,7 @@ void CheckNullUsage(Configuration& state,
                     const std::string& sql_statement,
                     bool& print_statement) {
 
-  std::regex pattern("(null)");
+  static const Matcher pattern(PATTERN_NULL_USAGE);
   std::string title = "NULL Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -641,12 +623,7 @@ void CheckNotNullUsage(Configuration& state,
                        const std::string& sql_statement,
                        bool& print_statement) {
 
-  auto create_statement = IsCreateStatement(sql_statement);
-  if(create_statement == false){
-    return;
-  }
-
-  std::regex pattern("(not null)");
+  static const Matcher pattern(PATTERN_NOT_NULL_USAGE);
   std::string title = "NOT NULL Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -673,7 +650,7 @@ void CheckConcatenation(Configuration& state,
                         bool& print_statement) {
 
 
-  std::regex pattern("\\|\\|");
+  static const Matcher pattern(PATTERN_CONCATENATION);
   std::string title = "String Concatenation";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -702,7 +679,7 @@ void CheckGroupByUsage(Configuration& state,
                        const std::string& sql_statement,
                        bool& print_statement){
 
-  std::regex pattern("(group by)");
+  static const Matcher pattern(PATTERN_GROUP_BY_USAGE);
   std::string title = "GROUP BY Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -736,7 +713,7 @@ void CheckOrderByRand(Configuration& state,
                       const std::string& sql_statement,
                       bool& print_statement){
 
-  std::regex pattern("(order by rand\\()");
+  static const Matcher pattern(PATTERN_ORDER_BY_RAND);
   std::string title = "ORDER BY RAND Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -771,7 +748,7 @@ void CheckPatternMatching(Configuration& state,
                           const std::string& sql_statement,
                           bool& print_statement){
 
-  std::regex pattern("(\blike\b)|(\bregexp\b)|(\bsimilar to\b)");
+  static const Matcher pattern(PATTERN_PATTERN_MATCHING);
   std::string title = "Pattern Matching Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -801,20 +778,15 @@ void CheckSpaghettiQuery(Configuration& state,
                          const std::string& sql_statement,
                          bool& print_statement){
 
-  std::regex true_pattern(".+?");
-  std::regex false_pattern("pattern must not exist");
-  std::regex pattern;
+  static const Matcher true_pattern(PATTERN_SPAGHETTI_QUERY);
+  static const Matcher false_pattern(PATTERN_NO_SPAGHETTI_QUERY);
 
   std::string title = "Spaghetti Query Alert";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
   std::size_t spaghetti_query_char_count = 500;
 
-  if(sql_statement.size() >= spaghetti_query_char_count){
-    pattern = true_pattern;
-  }
-  else {
-    pattern = false_pattern;
-  }
+  const Matcher& pattern =
+      (sql_statement.size() >= spaghetti_query_char_count) ? true_pattern : false_pattern;
 
   auto message =
       "● Split up a complex spaghetti query into several simpler queries:  "
@@ -855,7 +827,7 @@ void CheckJoinCount(Configuration& state,
                     const std::string& sql_statement,
                     bool& print_statement){
 
-  std::regex pattern("(\bjoin\b)");
+  static const Matcher pattern(PATTERN_JOIN_COUNT);
   std::string title = "Reduce Number of JOINs";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
   std::size_t min_count = 5;
@@ -882,7 +854,7 @@ void CheckDistinctCount(Configuration& state,
                         const std::string& sql_statement,
                         bool& print_statement){
 
-  std::regex pattern("(\bdistinct\b)");
+  static const Matcher pattern(PATTERN_DISTINCT_COUNT);
   std::string title = "Eliminate Unnecessary DISTINCT Conditions";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
   std::size_t min_count = 5;
@@ -912,7 +884,7 @@ void CheckImplicitColumns(Configuration& state,
                           const std::string& sql_statement,
                           bool& print_statement){
 
-  std::regex pattern("(insert into \\S+ values)");
+  static const Matcher pattern(PATTERN_IMPLICIT_COLUMNS);
   std::string title = "Implicit Column Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -940,7 +912,7 @@ void CheckHaving(Configuration& state,
                  const std::string& sql_statement,
                  bool& print_statement){
 
-  std::regex pattern("(\bhaving\b)");
+  static const Matcher pattern(PATTERN_HAVING);
   std::string title = "HAVING Clause Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -969,7 +941,7 @@ void CheckNesting(Configuration& state,
                   const std::string& sql_statement,
                   bool& print_statement){
 
-  std::regex pattern("(\bselect\b)");
+  static const Matcher pattern(PATTERN_NESTING);
   std::string title = "Nested sub queries";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
   std::size_t min_count = 2;
@@ -1006,7 +978,7 @@ void CheckOr(Configuration& state,
                  const std::string& sql_statement,
                  bool& print_statement){
 
-  std::regex pattern("(\bor\b)");
+  static const Matcher pattern(PATTERN_OR);
   std::string title = "OR Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -1037,7 +1009,7 @@ void CheckUnion(Configuration& state,
                 const std::string& sql_statement,
                 bool& print_statement){
 
-  std::regex pattern("(union)");
+  static const Matcher pattern(PATTERN_UNION);
   std::string title = "UNION Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -1063,7 +1035,7 @@ void CheckDistinctJoin(Configuration& state,
                        const std::string& sql_statement,
                        bool& print_statement){
 
-  std::regex pattern("(distinct.*join)");
+  static const Matcher pattern(PATTERN_DISTINCT_JOIN);
   std::string title = "DISTINCT & JOIN Usage";
   PatternType pattern_type = PatternType::PATTERN_TYPE_QUERY;
 
@@ -1098,8 +1070,7 @@ void CheckReadablePasswords(Configuration& state,
                             const std::string& sql_statement,
                             bool& print_statement){
 
-  std::regex pattern("(password varchar)|(password text)|(password =)| "
-      "(pwd varchar)|(pwd text)|(pwd =)");
+  static const Matcher pattern(PATTERN_READABLE_PASSWORDS);
   std::string title = "Readable Passwords";
   PatternType pattern_type = PatternType::PATTERN_TYPE_APPLICATION;
 
@@ -1130,5 +1101,70 @@ void CheckReadablePasswords(Configuration& state,
 
 }
 
+// RULES
+
+const std::vector<Rule>& GetRules(){
+  static const Rule rule_list[] = {
+    // LOGICAL DATABASE DESIGN
+    {"MultiValuedAttribute", CheckMultiValuedAttribute, kAllStatementKinds, {}},
+    {"RecursiveDependency", CheckRecursiveDependency, kCreateTableKinds, {}},
+    {"PrimaryKeyExists", CheckPrimaryKeyExists, kCreateTableKinds, {}},
+    {"GenericPrimaryKey", CheckGenericPrimaryKey, kTableDefinitionKinds, {}},
+    {"ForeignKeyExists", CheckForeignKeyExists, kCreateTableKinds, {}},
+    {"VariableAttribute", CheckVariableAttribute, kCreateTableKinds, {}},
+    {"MetadataTribbles", CheckMetadataTribbles, kTableDefinitionKinds, {}},
+
+    // PHYSICAL DATABASE DESIGN
+    {"Float", CheckFloat, kAllStatementKinds, {}},
+    {"ValuesInDefinition", CheckValuesInDefinition, kTableDefinitionKinds, {}},
+    {"ExternalFiles", CheckExternalFiles, kAllStatementKinds, {}},
+    {"IndexCount", CheckIndexCount, kCreateTableKinds, {}},
+    {"IndexAttributeOrder", CheckIndexAttributeOrder, 1u << STATEMENT_KIND_CREATE_INDEX, {}},
+
+    // QUERY
+    {"SelectStar", CheckSelectStar, kQueryKinds, {}},
+    {"JoinWithoutEquality", CheckJoinWithoutEquality, kQueryKinds, {}},
+    {"NullUsage", CheckNullUsage, kAllStatementKinds, {}},
+    {"NotNullUsage", CheckNotNullUsage, kCreateTableKinds, {}},
+    {"Concatenation", CheckConcatenation, kQueryKinds, {}},
+    {"GroupByUsage", CheckGroupByUsage, kQueryKinds, {}},
+    {"OrderByRand", CheckOrderByRand, kQueryKinds, {KEYWORD_BY}},
+    {"PatternMatching", CheckPatternMatching, kQueryKinds, {}},
+    {"SpaghettiQuery", CheckSpaghettiQuery, kAllStatementKinds, {}},
+    {"JoinCount", CheckJoinCount, kQueryKinds, {KEYWORD_JOIN}},
+    {"DistinctCount", CheckDistinctCount, kQueryKinds, {KEYWORD_DISTINCT}},
+    {"ImplicitColumns", CheckImplicitColumns, kQueryKinds, {KEYWORD_INTO}},
+    {"Having", CheckHaving, kQueryKinds, {KEYWORD_HAVING}},
+    {"Nesting", CheckNesting, kQueryKinds, {KEYWORD_SELECT}},
+    {"Or", CheckOr, kQueryKinds, {KEYWORD_OR}},
+    {"Union", CheckUnion, kQueryKinds, {}},
+    {"DistinctJoin", CheckDistinctJoin, kQueryKinds, {}},
+
+    // APPLICATION
+    {"ReadablePasswords", CheckReadablePasswords, kAllStatementKinds, {}}
+  };
+  static_assert(sizeof(rule_list) / sizeof(rule_list[0]) == kRuleCount,
+                "kRuleCount must be the number of rules");
+
+  static const std::vector<Rule> rules(std::begin(rule_list), std::end(rule_list));
+  return rules;
+}
+
+const std::vector<size_t>& GetStatementRules(const StatementKind kind){
+  static const std::vector<std::vector<size_t>> statement_rules = [] {
+    const auto& rules = GetRules();
+    std::vector<std::vector<size_t>> kind_rules(kStatementKindCount);
+    for (size_t kind = 0; kind < kStatementKindCount; kind++) {
+      for (size_t rule = 0; rule < rules.size(); rule++) {
+        if (rules[rule].kinds & (1u << kind)) {
+          kind_rules[kind].push_back(rule);
+        }
+      }
+    }
+    return kind_rules;
+  }();
+  return statement_rules[kind];
+}
+
 }  // namespace machine
 
@@ -0,0 +1,281 @@
+// LITERALS SOURCE
+
+#include <algorithm>
+#include <cctype>
+
+#include "include/lexer.h"
+#include "include/literals.h"
+#include "include/matcher.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Parenthesized list of literals
+struct LiteralList {
+
+  // offset after the closing parenthesis
+  size_t end;
+
+  // offset after the first literal
+  size_t first_item_end;
+
+  size_t item_count;
+
+};
+
+bool IsSpace(const char c){
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool IsWordCharacter(const char c){
+  return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+size_t SkipSpaces(const std::string& text, size_t position){
+  while (position < text.size() && IsSpace(text[position])) {
+    position++;
+  }
+  return position;
+}
+
+// Offset after the literal at position (string, number, literal word or
+// placeholder), npos if there is none
+size_t ScanLiteral(const std::string& text, size_t position){
+  auto c = text[position];
+
+  if (c == '\'') {
+    return SkipQuotedText(text, position);
+  }
+  if (c == '?') {
+    return position + 1;
+  }
+
+  if (isalpha(static_cast<unsigned char>(c))) {
+    auto end = position;
+    while (end < text.size() && IsWordCharacter(text[end])) {
+      end++;
+    }
+    switch (LookupKeyword(text.data() + position, end - position)) {
+      case KEYWORD_NULL:
+      case KEYWORD_TRUE:
+      case KEYWORD_FALSE:
+      case KEYWORD_DEFAULT:
+        return end;
+      default:
+        return std::string::npos;
+    }
+  }
+
+  // Numbers, with a sign, a fraction, an exponent or in hexadecimal
+  if (c == '-' || c == '+') {
+    position++;
+  }
+  auto number_start = position;
+  if (position == text.size() ||
+      (isdigit(static_cast<unsigned char>(text[position])) == false && text[position] != '.')) {
+    return std::string::npos;
+  }
+
+  bool has_digit = false;
+  while (position < text.size()) {
+    auto d = text[position];
+    if (isdigit(static_cast<unsigned char>(d))) {
+      has_digit = true;
+    }
+    else if ((d == '-' || d == '+') && position > number_start &&
+             (text[position - 1] == 'e' || text[position - 1] == 'E')) {
+    }
+    else if (d != '.' && isalpha(static_cast<unsigned char>(d)) == false) {
+      break;
+    }
+    position++;
+  }
+
+  return has_digit ? position : std::string::npos;
+}
+
+// Scan a list of literals with its opening parenthesis at position
+bool ScanLiteralList(const std::string& text, size_t position, LiteralList& list){
+  list.item_count = 0;
+  position++;
+
+  while (true) {
+    position = SkipSpaces(text, position);
+    if (position == text.size()) {
+      return false;
+    }
+
+    auto end = ScanLiteral(text, position);
+    if (end == std::string::npos) {
+      return false;
+    }
+    if (list.item_count == 0) {
+      list.first_item_end = end;
+    }
+    list.item_count++;
+
+    position = SkipSpaces(text, end);
+    if (position == text.size()) {
+      return false;
+    }
+    if (text[position] == ')') {
+      list.end = position + 1;
+      return true;
+    }
+    if (text[position] != ',') {
+      return false;
+    }
+    position++;
+  }
+}
+
+// Whether removing the literals between two offsets would hide a match of a
+// built-in pattern from its rule. NULLs are kept by the placeholder, and
+// the Spaghetti Query rule only looks at the size of the statement.
+bool HidesPattern(const std::string& text, const size_t begin, const size_t end){
+  for (size_t pattern = 0; pattern < kPatternCount; pattern++) {
+    auto pattern_id = static_cast<PatternId>(pattern);
+    if (pattern_id == PATTERN_NULL_USAGE || pattern_id == PATTERN_SPAGHETTI_QUERY) {
+      continue;
+    }
+    if (MatchPattern(pattern_id, text.data() + begin, end - begin)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+void CollapseLiteralLists(std::string& statement, LineShifts& line_shifts){
+
+  line_shifts.clear();
+
+  // Most statements have no list at all
+  if (statement.find('(') == std::string::npos) {
+    return;
+  }
+
+  std::string collapsed;
+  size_t copied = 0;
+  std::uint32_t removed_lines = 0;
+  size_t position = 0;
+
+  while (position < statement.size()) {
+    auto c = statement[position];
+
+    // Parentheses in strings, quoted identifiers and comments are text
+    if (c == '\'' || c == '"' || c == '`') {
+      position = SkipQuotedText(statement, position);
+      if (position == std::string::npos) {
+        break;
+      }
+      continue;
+    }
+    if (c == '-' && statement.compare(position, 2, "--") == 0) {
+      position = statement.find('\n', position);
+      continue;
+    }
+    if (c == '/' && statement.compare(position, 2, "/*") == 0) {
+      position = statement.find("*/", position + 2);
+      if (position == std::string::npos) {
+        break;
+      }
+      position += 2;
+      continue;
+    }
+    if (c != '(') {
+      position++;
+      continue;
+    }
+
+    LiteralList list;
+    if (ScanLiteralList(statement, position, list) == false) {
+      position++;
+      continue;
+    }
+
+    // Run of tuples separated by commas
+    size_t tuple_count = 1;
+    size_t end = list.end;
+    while (true) {
+      auto comma = SkipSpaces(statement, end);
+      if (comma == statement.size() || statement[comma] != ',') {
+        break;
+      }
+      auto next = SkipSpaces(statement, comma + 1);
+      LiteralList next_list;
+      if (next == statement.size() || statement[next] != '(' ||
+          ScanLiteralList(statement, next, next_list) == false) {
+        break;
+      }
+      tuple_count++;
+      end = next_list.end;
+    }
+
+    size_t keep_end;
+    if (tuple_count >= kCollapsedListSize) {
+      keep_end = list.end;
+    }
+    else if (list.item_count >= kCollapsedListSize) {
+      keep_end = list.first_item_end;
+      end = list.end;
+    }
+    else {
+      position = list.end;
+      continue;
+    }
+
+    // Lists with literals that rules look for are kept, and the placeholder
+    // keeps the NULLs of the removed literals for the NULL Usage rule
+    if (HidesPattern(statement, keep_end, end)) {
+      position = end;
+      continue;
+    }
+    bool has_null = MatchPattern(PATTERN_NULL_USAGE, statement.data() + keep_end,
+                                 end - keep_end);
+    const char* placeholder;
+    if (tuple_count >= kCollapsedListSize) {
+      placeholder = has_null ? ", (?, null)" : ", (?)";
+    }
+    else {
+      placeholder = has_null ? ", ?, null)" : ", ?)";
+    }
+
+    collapsed.append(statement, copied, keep_end - copied);
+    collapsed += placeholder;
+    auto lines = static_cast<std::uint32_t>(
+        std::count(statement.begin() + keep_end, statement.begin() + end, '\n'));
+    if (lines != 0) {
+      removed_lines += lines;
+      LineShift line_shift;
+      line_shift.offset = collapsed.size();
+      line_shift.lines = removed_lines;
+      line_shifts.push_back(line_shift);
+    }
+
+    copied = end;
+    position = end;
+  }
+
+  if (copied == 0) {
+    return;
+  }
+  collapsed.append(statement, copied, std::string::npos);
+  statement.swap(collapsed);
+}
+
+std::uint32_t GetRemovedLines(const LineShifts& line_shifts, const size_t offset){
+  // Last shift at or before the offset
+  auto shift = std::upper_bound(line_shifts.begin(), line_shifts.end(), offset,
+                                [](size_t value, const LineShift& line_shift) {
+                                  return value < line_shift.offset;
+                                });
+  if (shift == line_shifts.begin()) {
+    return 0;
+  }
+  return (shift - 1)->lines;
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,566 @@
+// LSP SOURCE
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "include/lsp.h"
+#include "include/checker.h"
+#include "include/interner.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Diagnostic severities defined by the protocol
+enum LspSeverity {
+  LSP_SEVERITY_ERROR = 1,
+  LSP_SEVERITY_WARNING = 2,
+  LSP_SEVERITY_INFORMATION = 3,
+  LSP_SEVERITY_HINT = 4
+};
+
+// JSON-RPC error codes
+const int kMethodNotFound = -32601;
+const int kInvalidRequest = -32600;
+
+LspSeverity RiskLevelToSeverity(const RiskLevel& risk_level){
+
+  switch (risk_level) {
+    case RISK_LEVEL_HIGH:
+      return LSP_SEVERITY_ERROR;
+    case RISK_LEVEL_MEDIUM:
+      return LSP_SEVERITY_WARNING;
+    case RISK_LEVEL_LOW:
+      return LSP_SEVERITY_INFORMATION;
+    default:
+      return LSP_SEVERITY_HINT;
+  }
+
+}
+
+// Number of UTF-16 code units taken by the UTF-8 sequence starting with c
+size_t Utf16Length(const unsigned char c){
+  return (c >= 0xF0) ? 2 : 1;
+}
+
+bool IsUtf8Continuation(const unsigned char c){
+  return (c & 0xC0) == 0x80;
+}
+
+// Byte offset of the first byte of a zero-based line
+size_t GetLineOffset(const LspDocument& document, const std::uint32_t line){
+
+  const auto& statements = document.statements;
+  const auto& text = document.text;
+
+  // Start from the last statement that begins before the line, since a
+  // statement beginning on the line need not begin at its first byte
+  auto it = std::lower_bound(statements.begin(), statements.end(), line,
+                             [](const LspStatement& statement, const std::uint32_t target) {
+                               return statement.line < target;
+                             });
+
+  size_t offset = 0;
+  std::uint32_t current_line = 0;
+  if (it != statements.begin()) {
+    --it;
+    offset = it->offset;
+    current_line = it->line;
+  }
+
+  while (current_line < line) {
+    auto newline = static_cast<const char*>(
+        memchr(text.data() + offset, '\n', text.size() - offset));
+    if (newline == nullptr) {
+      return text.size();
+    }
+    offset = newline - text.data() + 1;
+    current_line++;
+  }
+
+  return offset;
+}
+
+// Protocol position number, clamped to [0, UINT32_MAX] as the JSON number
+// may be negative, fractional or too large
+std::uint32_t GetPositionNumber(const JsonValue& value){
+
+  if (std::isfinite(value.number) == false || value.number <= 0) {
+    return 0;
+  }
+  if (value.number >= static_cast<double>(UINT32_MAX)) {
+    return UINT32_MAX;
+  }
+  return static_cast<std::uint32_t>(value.number);
+}
+
+// Byte offset of a protocol position (line and UTF-16 character)
+size_t GetPositionOffset(const LspDocument& document, const JsonValue& position){
+
+  auto line = GetPositionNumber(position.Get("line"));
+  size_t character = GetPositionNumber(position.Get("character"));
+  const auto& text = document.text;
+
+  auto offset = GetLineOffset(document, line);
+  size_t units = 0;
+  while (offset < text.size() && text[offset] != '\n' && units < character) {
+    units += Utf16Length(static_cast<unsigned char>(text[offset]));
+    offset++;
+    while (offset < text.size() &&
+        IsUtf8Continuation(static_cast<unsigned char>(text[offset]))) {
+      offset++;
+    }
+  }
+
+  return offset;
+}
+
+// UTF-16 length of text[begin, end)
+size_t GetUtf16Length(const std::string& text, const size_t begin, const size_t end){
+  size_t units = 0;
+  for (size_t i = begin; i < end; i++) {
+    auto c = static_cast<unsigned char>(text[i]);
+    if (IsUtf8Continuation(c) == false) {
+      units += Utf16Length(c);
+    }
+  }
+  return units;
+}
+
+void AppendPosition(std::string& output, const std::uint32_t line, const size_t character){
+  output += "{\"line\":" + std::to_string(line) +
+      ",\"character\":" + std::to_string(character) + "}";
+}
+
+}  // namespace
+
+LspServer::LspServer(Configuration& state, std::ostream& output)
+ : state_(state),
+   output_(output),
+   shutdown_(false),
+   checked_statement_count_(0){
+}
+
+const LspDocument* LspServer::GetDocument(const std::string& uri) const {
+  auto document = documents_.find(uri);
+  if (document == documents_.end()) {
+    return nullptr;
+  }
+  return &document->second;
+}
+
+bool LspServer::HandleMessage(const std::string& message){
+
+  JsonValue request;
+  if (ParseJson(message, request) == false || request.type != JSON_TYPE_OBJECT) {
+    return true;
+  }
+
+  const auto& method = request.Get("method").string;
+  const auto& id = request.Get("id");
+
+  if (method == "exit") {
+    return false;
+  }
+
+  if (id.IsNull()) {
+    HandleNotification(method, request.Get("params"));
+  }
+  else {
+    HandleRequest(id, method, request.Get("params"));
+  }
+
+  return true;
+}
+
+void LspServer::HandleRequest(const JsonValue& id,
+                              const std::string& method,
+                              const JsonValue& params){
+
+  (void) params;
+
+  std::string response = "{\"jsonrpc\":\"2.0\",\"id\":" + ToJson(id) + ",";
+
+  if (method == "initialize") {
+    // Incremental document sync so that edits only touch their statements
+    response +=
+        "\"result\":{\"capabilities\":{\"textDocumentSync\":"
+        "{\"openClose\":true,\"change\":2}},"
+        "\"serverInfo\":{\"name\":\"sqlcheck\"}}}";
+  }
+  else if (method == "shutdown") {
+    shutdown_ = true;
+    response += "\"result\":null}";
+  }
+  else {
+    auto code = method.empty() ? kInvalidRequest : kMethodNotFound;
+    response += "\"error\":{\"code\":" + std::to_string(code) +
+        ",\"message\":\"Unsupported method\"}}";
+  }
+
+  SendMessage(response);
+}
+
+void LspServer::HandleNotification(const std::string& method,
+                                   const JsonValue& params){
+
+  const auto& text_document = params.Get("textDocument");
+  const auto& uri = text_document.Get("uri").string;
+
+  if (method == "textDocument/didOpen") {
+    OpenDocument(uri, text_document.Get("text").string);
+  }
+  else if (method == "textDocument/didChange") {
+    ChangeDocument(uri, params.Get("contentChanges"));
+  }
+  else if (method == "textDocument/didClose") {
+    CloseDocument(uri);
+  }
+
+}
+
+void LspServer::OpenDocument(const std::string& uri, const std::string& text){
+
+  auto& document = documents_[uri];
+  document.text.clear();
+  document.statements.clear();
+
+  // A single statement covering the empty text, then edit it in
+  LspStatement statement;
+  statement.offset = 0;
+  statement.length = 0;
+  statement.line = 0;
+  statement.line_adjust = 0;
+  statement.has_diagnostics = false;
+  statement.published_line = 0;
+  document.statements.push_back(statement);
+
+  EditDocument(document, 0, 0, text);
+  PublishDiagnostics(uri, document);
+}
+
+void LspServer::ChangeDocument(const std::string& uri, const JsonValue& changes){
+
+  auto it = documents_.find(uri);
+  if (it == documents_.end()) {
+    return;
+  }
+
+  auto& document = it->second;
+  for (const auto& change : changes.array) {
+    const auto& range = change.Get("range");
+    if (range.IsNull()) {
+      EditDocument(document, 0, document.text.size(), change.Get("text").string);
+    }
+    else {
+      auto begin = GetPositionOffset(document, range.Get("start"));
+      auto end = GetPositionOffset(document, range.Get("end"));
+      EditDocument(document, begin, std::max(begin, end), change.Get("text").string);
+    }
+  }
+
+  PublishDiagnostics(uri, document);
+}
+
+void LspServer::CloseDocument(const std::string& uri){
+
+  documents_.erase(uri);
+
+  // Clear the diagnostics of the closed document
+  std::string notification =
+      "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+      "\"params\":{\"uri\":";
+  AppendJsonString(notification, uri);
+  notification += ",\"diagnostics\":[]}}";
+  SendMessage(notification);
+}
+
+void LspServer::EditDocument(LspDocument& document,
+                             const size_t begin,
+                             const size_t end,
+                             const std::string& text){
+
+  // Table name ids only live while a statement is checked, so the session
+  // does not keep the names of every edit
+  GetInterner().Clear();
+
+  auto& statements = document.statements;
+  auto delimiter = state_.delimiter[0];
+
+  // First statement whose text or delimiter is touched by the edit
+  auto first_statement =
+      std::lower_bound(statements.begin(), statements.end() - 1, begin,
+                       [](const LspStatement& statement, const size_t offset) {
+                         return statement.offset + statement.length < offset;
+                       });
+  size_t first = first_statement - statements.begin();
+
+  auto line_delta =
+      static_cast<std::int64_t>(std::count(text.begin(), text.end(), '\n')) -
+      static_cast<std::int64_t>(std::count(document.text.begin() + begin,
+                                           document.text.begin() + end, '\n'));
+  auto offset_delta =
+      static_cast<std::int64_t>(text.size()) - static_cast<std::int64_t>(end - begin);
+
+  auto edit_line = statements[first].line + static_cast<std::uint32_t>(
+      std::count(document.text.begin() + statements[first].offset,
+                 document.text.begin() + begin, '\n'));
+
+  document.text.replace(begin, end - begin, text);
+  const auto& new_text = document.text;
+  auto edit_end = begin + text.size();
+
+  // Re-split from the first touched statement until a statement boundary
+  // lines up with an old boundary past the edit
+  std::vector<LspStatement> new_statements;
+  size_t position = statements[first].offset;
+  std::uint32_t line = statements[first].line;
+  size_t old_index = first;
+  size_t last = statements.size() - 1;
+  bool resynced = false;
+
+  while (true) {
+    LspStatement statement;
+    statement.offset = position;
+    statement.line = line;
+    statement.line_adjust = 0;
+    statement.has_diagnostics = false;
+    statement.published_line = 0;
+
+    auto found = static_cast<const char*>(
+        memchr(new_text.data() + position, delimiter, new_text.size() - position));
+    if (found == nullptr) {
+      statement.length = new_text.size() - position;
+      new_statements.push_back(statement);
+      break;
+    }
+
+    size_t boundary = found - new_text.data();
+    statement.length = boundary - position;
+    new_statements.push_back(statement);
+    line += static_cast<std::uint32_t>(
+        std::count(new_text.begin() + position, new_text.begin() + boundary, '\n'));
+    position = boundary + 1;
+
+    if (boundary >= edit_end) {
+      auto old_boundary = boundary - offset_delta;
+      while (old_index < last &&
+          statements[old_index].offset + statements[old_index].length < old_boundary) {
+        old_index++;
+      }
+      if (old_index < last &&
+          statements[old_index].offset + statements[old_index].length == old_boundary) {
+        last = old_index;
+        resynced = true;
+        break;
+      }
+    }
+  }
+
+  // Shift the untouched statements after the edit
+  if (resynced) {
+    for (size_t i = last + 1; i < statements.size(); i++) {
+      statements[i].offset = static_cast<size_t>(statements[i].offset + offset_delta);
+      statements[i].line = static_cast<std::uint32_t>(statements[i].line + line_delta);
+    }
+  }
+
+  for (auto& statement : new_statements) {
+    CheckDocumentStatement(document, statement);
+  }
+
+  statements.erase(statements.begin() + first, statements.begin() + last + 1);
+  statements.insert(statements.begin() + first,
+                    new_statements.begin(), new_statements.end());
+
+  // Diagnostic ranges of untouched statements sharing an edited line are stale
+  for (size_t i = first; i > 0 && statements[i].line == edit_line; i--) {
+    statements[i - 1].has_diagnostics = false;
+  }
+  auto edit_end_line = edit_line + std::count(text.begin(), text.end(), '\n');
+  for (size_t i = first + new_statements.size();
+      i < statements.size() && statements[i].line <= edit_end_line; i++) {
+    statements[i].has_diagnostics = false;
+  }
+}
+
+void LspServer::CheckDocumentStatement(const LspDocument& document,
+                                       LspStatement& statement){
+
+  // Same statement text as the command line checker
+  std::string sql_statement(document.text, statement.offset, statement.length);
+  if (sql_statement.empty() == false) {
+    sql_statement += " ";
+  }
+
+  state_.line_number = statement.line;
+  auto normalized_statement = NormalizeStatement(state_, sql_statement);
+  statement.line_adjust = state_.line_number - statement.line;
+
+  CollectFindings(state_, normalized_statement);
+  statement.findings.swap(state_.findings);
+  state_.findings.clear();
+
+  checked_statement_count_++;
+}
+
+void LspServer::BuildDiagnostics(const LspDocument& document, LspStatement& statement){
+
+  const auto& text = document.text;
+  statement.diagnostics.clear();
+
+  for (const auto& finding : statement.findings) {
+
+    std::string message = finding.title;
+    if (finding.exists == true) {
+      message += " [Matching Expression: " + finding.match + "]";
+    }
+    if (state_.verbose == true) {
+      message += "\n\n" + finding.message;
+    }
+
+    std::string body = ",\"severity\":" +
+        std::to_string(RiskLevelToSeverity(finding.risk_level)) +
+        ",\"source\":\"sqlcheck\",\"code\":";
+    AppendJsonString(body, PatternTypeToString(finding.pattern_type));
+    body += ",\"message\":";
+    AppendJsonString(body, message);
+    body += "}";
+
+    // One diagnostic per distinct line, or the statement line if none
+    auto lines = finding.lines;
+    if (lines.empty()) {
+      lines.push_back(0);
+    }
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+    for (auto relative_line : lines) {
+      LspDiagnostic diagnostic;
+      diagnostic.line = statement.line_adjust + relative_line;
+
+      // Range spans the text of the line, without its indentation
+      auto line_begin = GetLineOffset(document, statement.line + diagnostic.line);
+      auto line_end = text.find('\n', line_begin);
+      if (line_end == std::string::npos) {
+        line_end = text.size();
+      }
+      auto text_begin = line_begin;
+      while (text_begin < line_end && (text[text_begin] == ' ' || text[text_begin] == '\t')) {
+        text_begin++;
+      }
+      diagnostic.start_character = GetUtf16Length(text, line_begin, text_begin);
+      diagnostic.end_character =
+          diagnostic.start_character + GetUtf16Length(text, text_begin, line_end);
+      diagnostic.body = body;
+
+      statement.diagnostics.push_back(diagnostic);
+    }
+  }
+
+  statement.has_diagnostics = true;
+  statement.published.clear();
+}
+
+void LspServer::PublishDiagnostics(const std::string& uri, LspDocument& document){
+
+  std::string notification =
+      "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+      "\"params\":{\"uri\":";
+  AppendJsonString(notification, uri);
+  notification += ",\"diagnostics\":[";
+
+  bool first_diagnostic = true;
+
+  for (auto& statement : document.statements) {
+
+    if (statement.has_diagnostics == false) {
+      BuildDiagnostics(document, statement);
+    }
+
+    // Serialize again only if the statement moved to another line
+    if (statement.published.empty() || statement.published_line != statement.line) {
+      statement.published.clear();
+      for (const auto& diagnostic : statement.diagnostics) {
+        auto line = statement.line + diagnostic.line;
+        statement.published += "{\"range\":{\"start\":";
+        AppendPosition(statement.published, line, diagnostic.start_character);
+        statement.published += ",\"end\":";
+        AppendPosition(statement.published, line, diagnostic.end_character);
+        statement.published += "}";
+        statement.published += diagnostic.body;
+        statement.published += ",";
+      }
+      statement.published_line = statement.line;
+    }
+
+    if (statement.diagnostics.empty() == false) {
+      if (first_diagnostic == false) {
+        notification += ",";
+      }
+      first_diagnostic = false;
+      // Drop the trailing separator
+      notification.append(statement.published, 0, statement.published.size() - 1);
+    }
+  }
+
+  notification += "]}}";
+  SendMessage(notification);
+}
+
+void LspServer::SendMessage(const std::string& body){
+  output_ << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+  output_.flush();
+}
+
+int RunLspServer(Configuration& state,
+                 std::istream& input,
+                 std::ostream& output){
+
+  LspServer server(state, output);
+  std::string header;
+
+  while (true) {
+
+    // Headers, terminated by an empty line
+    size_t content_length = 0;
+    bool has_content_length = false;
+    while (std::getline(input, header)) {
+      if (header.empty() == false && header.back() == '\r') {
+        header.pop_back();
+      }
+      if (header.empty()) {
+        break;
+      }
+      const std::string content_length_header = "Content-Length:";
+      if (header.compare(0, content_length_header.size(), content_length_header) == 0) {
+        content_length = std::strtoul(header.c_str() + content_length_header.size(), nullptr, 10);
+        has_content_length = true;
+      }
+    }
+
+    if (input.good() == false) {
+      break;
+    }
+    if (has_content_length == false) {
+      continue;
+    }
+
+    std::string body(content_length, '\0');
+    input.read(&body[0], content_length);
+    if (static_cast<size_t>(input.gcount()) != content_length) {
+      break;
+    }
+
+    if (server.HandleMessage(body) == false) {
+      break;
+    }
+  }
+
+  return server.IsShutdown() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace sqlcheck
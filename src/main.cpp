@@ -1,13 +1,25 @@
 // MAIN SOURCE
 
 #include <iostream>
+#include <algorithm>
 #include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "checker.h"
 #include "include/configuration.h"
+#include "include/lsp.h"
+#include "include/reader.h"
 
 #include "gflags/gflags.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/ioctl.h>
+#include <unistd.h>
+#define SQLCHECK_HAVE_TERMINAL_SIZE 1
+#endif
+
 namespace sqlcheck {
 
 Configuration state;
@@ -20,6 +32,8 @@ DEFINE_bool(v, false, "Display verbose warnings");
 DEFINE_bool(verbose, false, "Display verbose warnings");
 DEFINE_string(d, "", "Query delimiter string (default -- ;)");
 DEFINE_string(delimiter, "", "Query delimiter string (default -- ;)");
+DEFINE_bool(backslash_escapes, false,
+            "Backslashes escape quotes in strings, as in MySQL dumps");
 DEFINE_bool(h, false, "Print help message");
 DEFINE_uint64(r, sqlcheck::RISK_LEVEL_ALL,
               "Set of anti-patterns to check \n"
@@ -33,8 +47,39 @@ DEFINE_uint64(risk_level, sqlcheck::RISK_LEVEL_ALL,
               "3 (only high risk anti-patterns) \n");
 DEFINE_string(f, "", "SQL file name"); // standard input
 DEFINE_string(file_name, "", "SQL file name"); // standard input
+DEFINE_string(changed_lines, "",
+              "Only check statements overlapping the changed lines \n"
+              "(unified diff file or line ranges, e.g. 10-20,35)");
+DEFINE_bool(q, false, "Do not print the banner");
+DEFINE_bool(quiet, false, "Do not print the banner");
+DEFINE_bool(lsp, false, "Serve the Language Server Protocol over stdio");
+DEFINE_uint64(threads, 0, "Number of checker threads (default -- one per core)");
+DEFINE_string(trace, "", "Write a Chrome trace-event file of the stages and rules");
+DEFINE_bool(perf_counters, false,
+            "Report hardware performance counters per statement and per rule");
+DEFINE_uint64(width, 0, "Wrap the output at this many columns (default -- terminal width)");
+DEFINE_bool(no_wrap, false, "Print statements verbatim, without wrapping");
+DEFINE_uint64(cache_size, 16,
+              "Megabytes of findings remembered for repeated statements (0 to disable)");
+DEFINE_bool(dedup, false,
+            "Print each distinct statement of a file once, with the lines of its occurrences");
+
+// Columns of the terminal on stdout, 0 if stdout is not a terminal
+size_t GetTerminalWidth() {
+#ifdef SQLCHECK_HAVE_TERMINAL_SIZE
+  if(isatty(STDOUT_FILENO) == 0){
+    return 0;
+  }
+  struct winsize window_size;
+  if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &window_size) == 0 && window_size.ws_col > 0){
+    return window_size.ws_col;
+  }
+#endif
+  return 80;
+}
 
-void ConfigureChecker(sqlcheck::Configuration &state) {
+void ConfigureChecker(sqlcheck::Configuration &state,
+                      const std::vector<std::string>& input_paths) {
 
   // Default Values
   state.risk_level = sqlcheck::RISK_LEVEL_ALL;
@@ -54,18 +99,94 @@ void ConfigureChecker(sqlcheck::Configuration &state) {
   if(FLAGS_file_name.empty() == false){
     state.file_name = FLAGS_file_name;
   }
+
+  // Directories and several files are checked one file after the other
+  auto paths = input_paths;
+  if(state.file_name.empty() == false){
+    paths.insert(paths.begin(), state.file_name);
+  }
+  bool has_directory = false;
+  for(const auto& path : paths){
+    auto file_count = state.file_names.size();
+    if(sqlcheck::CollectInputFiles(path, state.file_names) == false){
+      std::cout << "INVALID FILE NAME :: " << path << "\n";
+      exit(EXIT_FAILURE);
+    }
+    if(state.file_names.size() != file_count + 1 ||
+        state.file_names.back() != path){
+      has_directory = true;
+    }
+  }
+  if(paths.empty() == false && state.file_names.empty()){
+    std::cout << "NO SQL FILES FOUND :: " << paths[0] << "\n";
+    exit(EXIT_FAILURE);
+  }
+  if(paths.size() == 1 && has_directory == false){
+    state.file_name = paths[0];
+    state.file_names.clear();
+  }
+  else if(paths.empty() == false){
+    state.file_name = "";
+  }
   if(FLAGS_d.empty() == false){
     state.delimiter = FLAGS_f;
   }
   if(FLAGS_delimiter.empty() == false){
     state.delimiter = FLAGS_delimiter;
   }
+  state.backslash_escapes = FLAGS_backslash_escapes;
   if(FLAGS_r != 0){
     state.risk_level = (sqlcheck::RiskLevel) FLAGS_r;
   }
   if(FLAGS_risk_level != 0){
     state.risk_level = (sqlcheck::RiskLevel) FLAGS_risk_level;
   }
+  state.thread_count = FLAGS_threads;
+  if(state.thread_count == 0){
+    state.thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  state.trace_file = FLAGS_trace;
+  state.perf_counters_mode = FLAGS_perf_counters;
+  state.dedup_mode = FLAGS_dedup;
+  state.cache_size = FLAGS_cache_size << 20;
+
+  // Output piped to a file is not wrapped
+  if(FLAGS_no_wrap == true){
+    state.line_width = 0;
+  }
+  else if(FLAGS_width != 0){
+    state.line_width = FLAGS_width;
+  }
+  else{
+    state.line_width = GetTerminalWidth();
+  }
+  if(FLAGS_changed_lines.empty() == false){
+    state.changed_lines_mode = true;
+    bool valid = true;
+    if(state.file_names.empty()){
+      valid = sqlcheck::ParseChangedLines(FLAGS_changed_lines,
+                                          state.file_name,
+                                          state.changed_lines);
+    }
+    else{
+      // Each file has its own changed lines
+      state.file_changed_lines.resize(state.file_names.size());
+      for(size_t file = 0; file < state.file_names.size() && valid; file++){
+        valid = sqlcheck::ParseChangedLines(FLAGS_changed_lines,
+                                            state.file_names[file],
+                                            state.file_changed_lines[file]);
+      }
+    }
+    if(valid == false){
+      std::cout << "INVALID CHANGED LINES :: " << FLAGS_changed_lines << "\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // Keep stdout clean for the protocol
+  if(FLAGS_lsp == true || FLAGS_q == true || FLAGS_quiet == true){
+    return;
+  }
 
   // Run validators
   std::cout << "+-------------------------------------------------+\n"
@@ -77,6 +198,7 @@ void ConfigureChecker(sqlcheck::Configuration &state) {
   ValidateColorMode(state);
   ValidateVerbose(state);
   ValidateDelimiter(state);
+  ValidateChangedLines(state);
 
   std::cout << "-------------------------------------------------\n";
 
@@ -84,15 +206,32 @@ void ConfigureChecker(sqlcheck::Configuration &state) {
 
 void Usage() {
   std::cout <<
-      "Command line options : sqlcheck <options>\n"
-      "   -f -file_name          :  SQL file name\n"
+      "Command line options : sqlcheck <options> [files or directories]\n"
+      "   -f -file_name          :  SQL file name (or directory of .sql files)\n"
       "   -r -risk_level         :  Set of anti-patterns to check\n"
       "                          :  1 (all anti-patterns, default) \n"
       "                          :  2 (only medium and high risk anti-patterns) \n"
       "                          :  3 (only high risk anti-patterns) \n"
       "   -c -color_mode         :  Display warnings in color mode \n"
       "   -v -verbose            :  Display verbose warnings \n"
+      "   -q -quiet              :  Do not print the banner \n"
+      "   -width                 :  Wrap the output at this many columns \n"
+      "                          :  (terminal width by default, no wrapping if piped) \n"
+      "   -no_wrap               :  Print statements verbatim, without wrapping \n"
+      "   -cache_size            :  Megabytes of findings remembered for repeated \n"
+      "                          :  statements (default -- 16, 0 to disable) \n"
+      "   -dedup                 :  Print each distinct statement of a file once, \n"
+      "                          :  with the lines of its occurrences \n"
       "   -d -delimiter          :  Query delimiter string (; by default) \n"
+      "   -backslash_escapes     :  Backslashes escape quotes in strings, \n"
+      "                          :  as in MySQL dumps \n"
+      "   -changed_lines         :  Only check statements overlapping the changed lines \n"
+      "                          :  (unified diff file or line ranges, e.g. 10-20,35) \n"
+      "   -lsp                   :  Serve the Language Server Protocol over stdio \n"
+      "   -threads               :  Number of checker threads (one per core by default) \n"
+      "   -trace                 :  Write a Chrome trace-event file of the stages and rules \n"
+      "   -perf_counters         :  Report cycles, instructions, branch and LLC misses \n"
+      "                          :  per statement and per rule \n"
       "   -h -help               :  Print help message \n";
 }
 
@@ -117,8 +256,18 @@ int main(int argc, char **argv) {
       return (EXIT_SUCCESS);
     }
 
-    // Customize the checker configuration
-    ConfigureChecker(sqlcheck::state);
+    // Customize the checker configuration, the remaining arguments are
+    // additional input files
+    std::vector<std::string> input_paths(argv + 1, argv + argc);
+    ConfigureChecker(sqlcheck::state, input_paths);
+
+    // Serve editors instead of checking a file
+    if(FLAGS_lsp == true){
+      auto status = sqlcheck::RunLspServer(sqlcheck::state, std::cin, std::cout);
+
+      gflags::ShutDownCommandLineFlags();
+      return status;
+    }
 
     // Invoke the checker
     has_issues = sqlcheck::Check(sqlcheck::state);
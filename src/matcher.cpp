@@ -0,0 +1,183 @@
+// MATCHER SOURCE
+
+#include <climits>
+#include <vector>
+
+#ifdef SQLCHECK_HAVE_HYPERSCAN
+#include <hs/hs.h>
+#endif
+
+#include "include/matcher.h"
+
+namespace sqlcheck {
+
+namespace {
+
+#ifdef SQLCHECK_HAVE_HYPERSCAN
+
+// Hyperscan database of the built-in patterns, compiled on first use, whose
+// scans report each pattern with a match once
+class PatternDatabase {
+ public:
+  PatternDatabase()
+ : database_(nullptr),
+   unscanned_(kAllPatterns){
+    Compile();
+  }
+
+  ~PatternDatabase() {
+    if (database_ != nullptr) {
+      hs_free_database(database_);
+    }
+  }
+
+  PatternSet Scan(const std::string& text) const {
+    if (database_ == nullptr || text.size() > UINT_MAX) {
+      return kAllPatterns;
+    }
+
+    // Scratch space of the thread, grown for the database once
+    auto& scratch = GetScratch();
+    if (scratch.space == nullptr &&
+        hs_alloc_scratch(database_, &scratch.space) != HS_SUCCESS) {
+      return kAllPatterns;
+    }
+
+    PatternSet matches = 0;
+    if (hs_scan(database_, text.data(), static_cast<unsigned int>(text.size()), 0,
+                scratch.space, OnMatch, &matches) != HS_SUCCESS) {
+      return kAllPatterns;
+    }
+    return matches | unscanned_;
+  }
+
+  PatternDatabase(const PatternDatabase&) = delete;
+  PatternDatabase& operator=(const PatternDatabase&) = delete;
+
+ private:
+
+  struct Scratch {
+
+    Scratch()
+ : space(nullptr){
+    }
+
+    ~Scratch() {
+      if (space != nullptr) {
+        hs_free_scratch(space);
+      }
+    }
+
+    hs_scratch_t* space;
+
+  };
+
+  static Scratch& GetScratch(){
+    static thread_local Scratch scratch;
+    return scratch;
+  }
+
+  static int OnMatch(unsigned int id, unsigned long long, unsigned long long,
+                     unsigned int, void* context){
+    *static_cast<PatternSet*>(context) |= GetPatternBit(static_cast<PatternId>(id));
+    return 0;
+  }
+
+  // Compile the patterns in their folded form, as the regexes see them.
+  // Patterns Hyperscan rejects are left out, and never ruled out by a scan.
+  void Compile(){
+    std::vector<PatternId> patterns;
+    std::vector<std::string> texts;
+    for (size_t pattern = 0; pattern < kPatternCount; pattern++) {
+      patterns.push_back(static_cast<PatternId>(pattern));
+      texts.push_back(FoldPatternCase(GetPatternText(patterns.back())));
+    }
+
+    while (patterns.empty() == false) {
+      std::vector<const char*> expressions;
+      std::vector<unsigned int> flags;
+      std::vector<unsigned int> ids;
+      for (size_t index = 0; index < patterns.size(); index++) {
+        expressions.push_back(texts[index].c_str());
+        flags.push_back(HS_FLAG_SINGLEMATCH);
+        ids.push_back(patterns[index]);
+      }
+
+      hs_compile_error_t* error = nullptr;
+      if (hs_compile_multi(expressions.data(), flags.data(), ids.data(),
+                           static_cast<unsigned int>(expressions.size()), HS_MODE_BLOCK,
+                           nullptr, &database_, &error) == HS_SUCCESS) {
+        for (auto pattern : patterns) {
+          unscanned_ &= ~GetPatternBit(pattern);
+        }
+        return;
+      }
+
+      auto expression = error->expression;
+      hs_free_compile_error(error);
+      database_ = nullptr;
+      if (expression < 0 || static_cast<size_t>(expression) >= patterns.size()) {
+        return;
+      }
+      patterns.erase(patterns.begin() + expression);
+      texts.erase(texts.begin() + expression);
+    }
+  }
+
+  hs_database_t* database_;
+
+  // patterns left out of the database
+  PatternSet unscanned_;
+
+};
+
+const PatternDatabase& GetPatternDatabase(){
+  static PatternDatabase database;
+  return database;
+}
+
+#endif
+
+}  // namespace
+
+PatternSet ScanPatterns(const std::string& text){
+#ifdef SQLCHECK_HAVE_HYPERSCAN
+  return GetPatternDatabase().Scan(text);
+#else
+  (void) text;
+  return kAllPatterns;
+#endif
+}
+
+Matcher::Matcher(const PatternId pattern)
+ : built_in_(true),
+   pattern_(pattern),
+   text_(FoldPatternCase(GetPatternText(pattern))),
+   flags_(std::regex::ECMAScript){
+}
+
+Matcher::Matcher(const std::string& pattern, const std::regex::flag_type flags)
+ : built_in_(false),
+   pattern_(PatternId()),
+   text_(pattern),
+   flags_(flags){
+}
+
+bool Matcher::MayMatch(const std::string& statement, const PatternSet candidates) const {
+  if (built_in_ == false) {
+    return true;
+  }
+  if ((candidates & GetPatternBit(pattern_)) == 0) {
+    return false;
+  }
+  return MatchPattern(pattern_, statement.data(), statement.size());
+}
+
+const std::regex& Matcher::GetRegex() const {
+  std::call_once(regex_once_, [this]() {
+    regex_.reset(new std::regex(text_, flags_));
+  });
+  return *regex_;
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,91 @@
+// PATTERNS SOURCE
+
+#include "include/patterns.h"
+
+namespace sqlcheck {
+
+namespace {
+
+const char* const kPatternNames[] = {
+#define SQLCHECK_PATTERN(identifier, pattern) #identifier,
+#include "include/patterns.def"
+#undef SQLCHECK_PATTERN
+};
+
+const char* const kPatternTexts[] = {
+#define SQLCHECK_PATTERN(identifier, pattern) pattern,
+#include "include/patterns.def"
+#undef SQLCHECK_PATTERN
+};
+
+}  // namespace
+
+const char* GetPatternName(const PatternId pattern){
+  return kPatternNames[pattern];
+}
+
+const char* GetPatternText(const PatternId pattern){
+  return kPatternTexts[pattern];
+}
+
+std::string FoldPatternCase(const std::string& pattern){
+  std::string folded;
+  bool in_class = false;
+
+  for (size_t i = 0; i < pattern.size(); i++) {
+    auto c = pattern[i];
+
+    // Escapes such as \s keep their letter
+    if (c == '\\' && i + 1 < pattern.size()) {
+      folded += c;
+      folded += pattern[++i];
+      continue;
+    }
+
+    if (in_class == false) {
+      if (c == '[') {
+        in_class = true;
+      }
+      if (c >= 'a' && c <= 'z') {
+        folded += '[';
+        folded += c;
+        folded += static_cast<char>(c - 'a' + 'A');
+        folded += ']';
+      }
+      else {
+        folded += c;
+      }
+      continue;
+    }
+
+    if (c == ']') {
+      in_class = false;
+      folded += c;
+      continue;
+    }
+
+    // Letters and ranges of letters of a class get their upper case twins
+    folded += c;
+    if (c >= 'a' && c <= 'z') {
+      if (i + 2 < pattern.size() && pattern[i + 1] == '-' &&
+          pattern[i + 2] >= 'a' && pattern[i + 2] <= 'z') {
+        folded += pattern.substr(i + 1, 2);
+        folded += static_cast<char>(c - 'a' + 'A');
+        folded += '-';
+        folded += static_cast<char>(pattern[i + 2] - 'a' + 'A');
+        i += 2;
+      }
+      else {
+        folded += static_cast<char>(c - 'a' + 'A');
+      }
+    }
+    else if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+      folded += pattern.substr(i + 1, 2);
+      i += 2;
+    }
+  }
+
+  return folded;
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,258 @@
+// PERF COUNTERS SOURCE
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#ifdef SQLCHECK_HAVE_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "include/perf_counters.h"
+
+namespace sqlcheck {
+
+bool perf_counters_enabled = false;
+
+namespace {
+
+// Counters of a thread and the counts it added to each slot
+struct ThreadCounters {
+
+  ThreadCounters()
+   : group_fd(-1),
+     counter_count(0),
+     open_error(0) {
+  }
+
+  ~ThreadCounters() {
+#ifdef SQLCHECK_HAVE_PERF_EVENTS
+    for (size_t i = 0; i < counter_count; i++) {
+      close(fds[i]);
+    }
+#endif
+  }
+
+  int group_fd;
+
+  // opened counters, in the order the group reads them
+  int fds[PERF_COUNTER_COUNT];
+  PerfCounter counters[PERF_COUNTER_COUNT];
+  size_t counter_count;
+
+  // errno of the failed open of the group
+  int open_error;
+
+  std::vector<PerfCounts> slots;
+
+};
+
+std::mutex counters_mutex;
+
+std::vector<std::unique_ptr<ThreadCounters>> thread_counters;
+
+size_t counters_slot_count = 0;
+
+// Incremented by each run, so that threads drop counters of previous runs
+size_t counters_generation = 0;
+
+thread_local ThreadCounters* current_counters = nullptr;
+
+thread_local size_t current_counters_generation = 0;
+
+#ifdef SQLCHECK_HAVE_PERF_EVENTS
+
+int OpenCounter(const PerfCounter counter, const int group_fd){
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.disabled = (group_fd == -1) ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+
+  switch (counter) {
+    case PERF_COUNTER_TASK_CLOCK:
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_TASK_CLOCK;
+      break;
+    case PERF_COUNTER_CYCLES:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PERF_COUNTER_INSTRUCTIONS:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PERF_COUNTER_BRANCH_MISSES:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    case PERF_COUNTER_LLC_MISSES:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_LL |
+          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    default:
+      return -1;
+  }
+
+  // Count the calling thread on any cpu
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+#endif
+
+// Open a group of the counters for the calling thread, led by the task
+// clock that every kernel with perf events provides
+void OpenCounters(ThreadCounters& counters){
+#ifdef SQLCHECK_HAVE_PERF_EVENTS
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    auto counter = static_cast<PerfCounter>(i);
+    auto fd = OpenCounter(counter, counters.group_fd);
+    if (fd == -1) {
+      if (counters.group_fd == -1) {
+        counters.open_error = errno;
+        return;
+      }
+      continue;
+    }
+    if (counters.group_fd == -1) {
+      counters.group_fd = fd;
+    }
+    counters.fds[counters.counter_count] = fd;
+    counters.counters[counters.counter_count] = counter;
+    counters.counter_count++;
+  }
+
+  ioctl(counters.group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+  (void) counters;
+#endif
+}
+
+ThreadCounters* GetThreadCounters(){
+  if (current_counters != nullptr && current_counters_generation == counters_generation) {
+    return current_counters;
+  }
+
+  std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+  OpenCounters(*counters);
+
+  std::lock_guard<std::mutex> lock(counters_mutex);
+  counters->slots.resize(counters_slot_count);
+  current_counters = counters.get();
+  current_counters_generation = counters_generation;
+  thread_counters.push_back(std::move(counters));
+  return current_counters;
+}
+
+}  // namespace
+
+std::string PerfCounterToString(const PerfCounter& counter){
+  switch (counter) {
+    case PERF_COUNTER_TASK_CLOCK:
+      return "TASK CLOCK (NS)";
+    case PERF_COUNTER_CYCLES:
+      return "CYCLES";
+    case PERF_COUNTER_INSTRUCTIONS:
+      return "INSTRUCTIONS";
+    case PERF_COUNTER_BRANCH_MISSES:
+      return "BRANCH MISSES";
+    case PERF_COUNTER_LLC_MISSES:
+      return "LLC MISSES";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+bool StartPerfCounters(const size_t slot_count, std::string& error){
+
+  {
+    std::lock_guard<std::mutex> lock(counters_mutex);
+    thread_counters.clear();
+    counters_slot_count = slot_count;
+    counters_generation++;
+  }
+
+#ifdef SQLCHECK_HAVE_PERF_EVENTS
+  // Probe with the counters of this thread
+  auto counters = GetThreadCounters();
+  if (counters->counter_count == 0) {
+    error = strerror(counters->open_error);
+    return false;
+  }
+
+  perf_counters_enabled = true;
+  return true;
+#else
+  error = "not supported on this platform";
+  return false;
+#endif
+}
+
+void ReadPerfCounters(PerfCounts& counts){
+  auto counters = GetThreadCounters();
+  memset(counts.values, 0, sizeof(counts.values));
+
+#ifdef SQLCHECK_HAVE_PERF_EVENTS
+  if (counters->counter_count == 0) {
+    return;
+  }
+
+  // Number of counters, then their values in group order
+  std::uint64_t buffer[1 + PERF_COUNTER_COUNT];
+  auto size = read(counters->group_fd, buffer, sizeof(buffer));
+  if (size < static_cast<ssize_t>(sizeof(std::uint64_t))) {
+    return;
+  }
+  for (size_t i = 0; i < counters->counter_count && i < buffer[0]; i++) {
+    counts.values[counters->counters[i]] = buffer[1 + i];
+  }
+#else
+  (void) counters;
+#endif
+}
+
+void AddPerfCounts(const size_t slot,
+                   const PerfCounts& start,
+                   const PerfCounts& end,
+                   const std::uint64_t sample_count){
+  auto& counts = GetThreadCounters()->slots[slot];
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    counts.values[i] += end.values[i] - start.values[i];
+  }
+  counts.sample_count += sample_count;
+}
+
+void StopPerfCounters(std::vector<PerfCounts>& slot_counts,
+                      bool available[PERF_COUNTER_COUNT]){
+  perf_counters_enabled = false;
+
+  std::lock_guard<std::mutex> lock(counters_mutex);
+  slot_counts.assign(counters_slot_count, PerfCounts());
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    available[i] = false;
+  }
+
+  for (const auto& counters : thread_counters) {
+    for (size_t i = 0; i < counters->counter_count; i++) {
+      available[counters->counters[i]] = true;
+    }
+    for (size_t slot = 0; slot < counters_slot_count; slot++) {
+      for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        slot_counts[slot].values[i] += counters->slots[slot].values[i];
+      }
+      slot_counts[slot].sample_count += counters->slots[slot].sample_count;
+    }
+  }
+
+  thread_counters.clear();
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,1141 @@
+// PIPELINE SOURCE
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SQLCHECK_HAVE_POSIX_IO 1
+#endif
+
+#include "include/pipeline.h"
+#include "include/cache.h"
+#include "include/checker.h"
+#include "include/list.h"
+#include "include/perf_counters.h"
+#include "include/queue.h"
+#include "include/reader.h"
+#include "include/scheduler.h"
+#include "include/splitter.h"
+#include "include/trace.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Size of the chunks handed from the reader to the splitter
+const size_t kChunkSize = 1 << 20;
+
+// Queue capacities
+const size_t kChunkQueueCapacity = 8;
+const size_t kOutputQueueCapacity = 1024;
+
+// Statements in flight, beyond which the splitter waits for the writer
+const std::uint64_t kStatementWindow = 8192;
+
+// Small statements are checked in batches by a single task
+const size_t kBatchStatementCount = 64;
+const size_t kBatchSize = 64 << 10;
+
+// Larger statements are checked by one task per check
+const size_t kLargeStatementSize = 8 << 10;
+
+// Mapped files are split in segments of this size
+const size_t kSegmentSize = 64 << 20;
+
+// Files read at once when checking several files
+const size_t kFileQueueDepth = 64;
+
+// Inputs read at once up to this size are checked without starting threads
+const size_t kSingleThreadInputSize = 64 << 10;
+
+// Lower case of an ASCII letter, other bytes as they are
+unsigned char FoldCase(const unsigned char c){
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Statements differing only in case are printed once in dedup mode
+std::uint64_t HashIgnoringCase(const std::string& text){
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (auto c : text) {
+    hash ^= FoldCase(static_cast<unsigned char>(c));
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool EqualIgnoringCase(const std::string& a, const std::string& b){
+  return a.size() == b.size() &&
+      std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+        return FoldCase(static_cast<unsigned char>(x)) == FoldCase(static_cast<unsigned char>(y));
+      });
+}
+
+// Bytes read from the input
+struct InputChunk {
+
+  InputChunk()
+   : data(nullptr),
+     size(0) {
+  }
+
+  // bytes of the chunk, in buffer or in a mapped file
+  const char* data;
+  size_t size;
+
+  // storage of chunks that are not mapped
+  std::string buffer;
+
+};
+
+// Statement handed from the splitter to the checkers
+struct Statement {
+
+  // index of the file of the statement in state.file_names
+  size_t file_index;
+
+  // line of the first byte of the statement
+  std::uint32_t line_number;
+
+  // statement text
+  std::string text;
+
+};
+
+// Consecutive statements checked by a single task
+struct StatementBatch {
+
+  StatementBatch()
+   : first_sequence(0),
+     size(0) {
+  }
+
+  // position of the first statement in the input
+  std::uint64_t first_sequence;
+
+  std::vector<Statement> statements;
+
+  // bytes of the statements
+  size_t size;
+
+};
+
+// Large statement checked by one task per check
+struct LargeStatement {
+
+  // position of the statement in the input
+  std::uint64_t sequence;
+
+  size_t file_index;
+
+  // line of the statement, then of its normalized text
+  std::uint32_t line_number;
+
+  // statement text, normalized by the first task
+  std::string statement;
+
+  // lines removed from the normalized text
+  LineShifts line_shifts;
+
+  // kind of the statement, table it creates and patterns that may match it
+  StatementKind statement_kind;
+  StringId table_name;
+  PatternSet pattern_matches;
+
+  StatementFingerprint fingerprint;
+
+  // findings of each check
+  std::vector<std::vector<Finding>> check_findings;
+
+  // checks that did not run yet
+  std::atomic<size_t> remaining_check_count;
+
+};
+
+// Statement with findings, printed once per file in dedup mode
+struct StatementRecord {
+
+  size_t file_index;
+
+  // hash of the normalized text, ignoring case
+  std::uint64_t fingerprint;
+
+  // line of the normalized text
+  std::uint32_t line_number;
+
+  // normalized text
+  std::string statement;
+
+  // findings printed without the statement
+  std::string findings;
+
+};
+
+// Printed findings handed from the checkers to the writer
+struct StatementOutput {
+
+  StatementOutput()
+   : sequence(0),
+     count(0),
+     end_of_input(false) {
+  }
+
+  // position of the first statement in the input
+  std::uint64_t sequence;
+
+  // number of statements
+  size_t count;
+
+  std::string text;
+
+  // statements with findings in dedup mode, instead of text
+  std::vector<StatementRecord> records;
+
+  // the checkers are done
+  bool end_of_input;
+
+};
+
+// READER
+
+class InputReader {
+ public:
+  virtual ~InputReader() {}
+
+  // Next chunk of input (nullptr at the end of the input)
+  virtual std::unique_ptr<InputChunk> Read() = 0;
+
+  // Whether the input is known to end after the chunks read so far
+  virtual bool AtEnd() const { return false; }
+};
+
+// Reads any input stream through a buffer
+class StreamReader : public InputReader {
+ public:
+  StreamReader(std::istream& input)
+ : input_(input){
+  }
+
+  std::unique_ptr<InputChunk> Read() {
+    if (input_.good() == false) {
+      return nullptr;
+    }
+
+    std::unique_ptr<InputChunk> chunk(new InputChunk());
+    chunk->buffer.resize(kChunkSize);
+    input_.read(&chunk->buffer[0], kChunkSize);
+    chunk->buffer.resize(static_cast<size_t>(input_.gcount()));
+    if (chunk->buffer.empty()) {
+      return nullptr;
+    }
+
+    chunk->data = chunk->buffer.data();
+    chunk->size = chunk->buffer.size();
+    return chunk;
+  }
+
+  bool AtEnd() const {
+    return input_.good() == false;
+  }
+
+ private:
+  std::istream& input_;
+};
+
+#ifdef SQLCHECK_HAVE_POSIX_IO
+
+// Reads a descriptor without waiting for full chunks, so that statements
+// piped interactively are checked as soon as they arrive
+class DescriptorReader : public InputReader {
+ public:
+  DescriptorReader(int descriptor)
+ : descriptor_(descriptor){
+  }
+
+  std::unique_ptr<InputChunk> Read() {
+    std::unique_ptr<InputChunk> chunk(new InputChunk());
+    chunk->buffer.resize(kChunkSize);
+
+    ssize_t bytes_read;
+    do {
+      bytes_read = ::read(descriptor_, &chunk->buffer[0], kChunkSize);
+    } while (bytes_read < 0 && errno == EINTR);
+
+    if (bytes_read <= 0) {
+      return nullptr;
+    }
+
+    chunk->buffer.resize(static_cast<size_t>(bytes_read));
+    chunk->data = chunk->buffer.data();
+    chunk->size = chunk->buffer.size();
+    return chunk;
+  }
+
+ private:
+  int descriptor_;
+};
+
+// Read-only memory mapping of a regular file
+class MappedFile {
+ public:
+  MappedFile()
+ : data_(nullptr),
+   size_(0){
+  }
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  // Returns false if the file cannot be mapped (e.g. empty or not regular)
+  bool Open(const std::string& file_name) {
+    int descriptor = open(file_name.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(descriptor, &file_stat) != 0 || S_ISREG(file_stat.st_mode) == false ||
+        file_stat.st_size == 0) {
+      close(descriptor);
+      return false;
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    data_ = static_cast<const char*>(data);
+    madvise(data, size_, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  const char* GetData() const { return data_; }
+
+  size_t GetSize() const { return size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+#endif
+
+std::unique_ptr<InputReader> OpenInput(Configuration& state,
+                                       std::unique_ptr<std::istream>& stream){
+
+  if (state.testing_mode == true) {
+    return std::unique_ptr<InputReader>(new StreamReader(*state.test_stream));
+  }
+
+  if (state.file_name.empty()) {
+#ifdef SQLCHECK_HAVE_POSIX_IO
+    return std::unique_ptr<InputReader>(new DescriptorReader(STDIN_FILENO));
+#else
+    return std::unique_ptr<InputReader>(new StreamReader(std::cin));
+#endif
+  }
+
+  stream.reset(new std::ifstream(state.file_name.c_str()));
+  return std::unique_ptr<InputReader>(new StreamReader(*stream));
+}
+
+// DEDUPLICATOR
+
+// Prints each distinct statement of a file once, with the lines of its
+// occurrences, after the last statement of the file
+class StatementDeduplicator {
+ public:
+  StatementDeduplicator(Configuration& state, std::ostream& output)
+ : state_(state),
+   output_(output),
+   file_index_(0){
+  }
+
+  // Add the records of statements, in input order
+  void Add(std::vector<StatementRecord>& records) {
+    for (auto& record : records) {
+      if (record.file_index != file_index_) {
+        Finish();
+        file_index_ = record.file_index;
+      }
+
+      // Statements with the same fingerprint but a different text (a hash
+      // collision) are printed separately, the first occurrence is printed
+      // for all
+      auto inserted = distinct_index_.emplace(record.fingerprint, distinct_.size());
+      if (inserted.second == false) {
+        auto& distinct = distinct_[inserted.first->second];
+        if (EqualIgnoringCase(distinct.record.statement, record.statement)) {
+          distinct.lines.push_back(record.line_number);
+          continue;
+        }
+      }
+
+      DistinctStatement distinct;
+      distinct.lines.push_back(record.line_number);
+      distinct.record = std::move(record);
+      distinct_.push_back(std::move(distinct));
+    }
+  }
+
+  // Print the distinct statements of the current file, in order of their
+  // first occurrence
+  void Finish() {
+    TraceSpan span("print distinct statements");
+    for (const auto& distinct : distinct_) {
+      PrintStatement(state_, output_, distinct.record.statement, distinct.lines);
+      output_.write(distinct.record.findings.data(), distinct.record.findings.size());
+    }
+    distinct_.clear();
+    distinct_index_.clear();
+  }
+
+ private:
+
+  struct DistinctStatement {
+
+    // first occurrence
+    StatementRecord record;
+
+    // lines of the occurrences
+    std::vector<std::uint32_t> lines;
+
+  };
+
+  Configuration& state_;
+
+  std::ostream& output_;
+
+  // file of the statements added since the last Finish
+  size_t file_index_;
+
+  std::vector<DistinctStatement> distinct_;
+
+  // index in distinct_ of each fingerprint
+  std::unordered_map<std::uint64_t, size_t> distinct_index_;
+};
+
+// CHECKER
+
+// Checks statements on a work-stealing scheduler, so that a few large
+// statements do not leave the other workers idle. Without a writer
+// (single_thread_output), statements are checked and written on the
+// splitter thread. In dedup mode, the findings are handed to the
+// deduplicator instead of being written.
+class StatementChecker {
+ public:
+  StatementChecker(Configuration& state,
+                   BoundedQueue<StatementOutput>& outputs,
+                   std::atomic<std::uint64_t>& written_sequence,
+                   std::ostream* single_thread_output,
+                   StatementDeduplicator* single_thread_deduplicator)
+ : worker_states_(std::max<size_t>(state.thread_count, 1), state),
+   outputs_(outputs),
+   written_sequence_(written_sequence),
+   single_thread_output_(single_thread_output),
+   single_thread_deduplicator_(single_thread_deduplicator),
+   finding_cache_(state.cache_size),
+   scheduler_(single_thread_output ? 0 : worker_states_.size()){
+    for (auto& worker_state : worker_states_) {
+      worker_state.checker_stats.Reset(state.file_names.size());
+    }
+  }
+
+  void CheckBatch(const std::shared_ptr<StatementBatch>& batch) {
+    scheduler_.Submit([this, batch](size_t worker) {
+      RunBatch(worker, *batch);
+    });
+  }
+
+  void CheckLargeStatement(const std::uint64_t sequence, Statement& statement) {
+    std::shared_ptr<LargeStatement> large_statement(new LargeStatement());
+    large_statement->sequence = sequence;
+    large_statement->file_index = statement.file_index;
+    large_statement->line_number = statement.line_number;
+    large_statement->statement.swap(statement.text);
+
+    scheduler_.Submit([this, large_statement](size_t worker) {
+      RunLargeStatement(worker, large_statement);
+    });
+  }
+
+  // Wait for the checks and merge their stats
+  void Finish(Configuration& state) {
+    scheduler_.Finish();
+
+    for (const auto& worker_state : worker_states_) {
+      state.checker_stats.AddFiles(worker_state.checker_stats);
+    }
+  }
+
+ private:
+
+  void RunBatch(const size_t worker, const StatementBatch& batch) {
+    auto& worker_state = worker_states_[worker];
+    std::ostringstream output;
+    std::vector<StatementRecord> records;
+
+    for (const auto& statement : batch.statements) {
+      PerfCounterScope counter_scope(GetStatementCounterSlot());
+      SetFile(worker_state, statement.file_index);
+      worker_state.line_number = statement.line_number;
+      auto normalized_statement = NormalizeStatement(worker_state, statement.text);
+      auto fingerprint = GetStatementFingerprint(normalized_statement,
+                                                 worker_state.line_shifts);
+      if (finding_cache_.Find(fingerprint, worker_state.findings) == false) {
+        CollectFindings(worker_state, normalized_statement);
+        finding_cache_.Insert(fingerprint, worker_state.findings);
+      }
+      Print(worker_state, statement.file_index, normalized_statement, output, records);
+    }
+
+    Write(batch.first_sequence, batch.statements.size(), output.str(), records);
+  }
+
+  // Normalize the statement and spawn its checks
+  void RunLargeStatement(const size_t worker,
+                         const std::shared_ptr<LargeStatement>& large_statement) {
+    PerfCounterScope counter_scope(GetStatementCounterSlot());
+    auto& worker_state = worker_states_[worker];
+    SetFile(worker_state, large_statement->file_index);
+    worker_state.line_number = large_statement->line_number;
+    large_statement->statement = NormalizeStatement(worker_state,
+                                                    large_statement->statement);
+    large_statement->line_number = worker_state.line_number;
+    large_statement->line_shifts = worker_state.line_shifts;
+
+    // Print the findings of a statement checked before
+    large_statement->fingerprint = GetStatementFingerprint(large_statement->statement,
+                                                           large_statement->line_shifts);
+    if (finding_cache_.Find(large_statement->fingerprint, worker_state.findings) == true) {
+      PrintLargeStatement(worker_state, *large_statement);
+      return;
+    }
+
+    // Only the rules applying to the kind of the statement, whose keywords
+    // are all in the statement
+    AnalyzeStatement(worker_state, large_statement->statement);
+    large_statement->statement_kind = worker_state.statement_kind;
+    large_statement->table_name = worker_state.table_name;
+    large_statement->pattern_matches = worker_state.pattern_matches;
+    const auto& rules = GetRules();
+    std::vector<size_t> checks;
+    for (auto rule : GetStatementRules(large_statement->statement_kind)) {
+      if (worker_state.keyword_set.ContainsAll(rules[rule].keywords) == true) {
+        checks.push_back(rule);
+      }
+    }
+    if (checks.empty()) {
+      worker_state.findings.clear();
+      finding_cache_.Insert(large_statement->fingerprint, worker_state.findings);
+      PrintLargeStatement(worker_state, *large_statement);
+      return;
+    }
+    large_statement->check_findings.resize(GetRules().size());
+    large_statement->remaining_check_count.store(checks.size());
+
+    for (auto check : checks) {
+      scheduler_.Spawn(worker, [this, large_statement, check](size_t check_worker) {
+        RunLargeStatementCheck(check_worker, large_statement, check);
+      });
+    }
+  }
+
+  // Run a check, the last one prints the findings in check order
+  void RunLargeStatementCheck(const size_t worker,
+                              const std::shared_ptr<LargeStatement>& large_statement,
+                              const size_t check) {
+    auto& worker_state = worker_states_[worker];
+    worker_state.findings.clear();
+    bool print_statement = true;
+    const auto& rule = GetRules()[check];
+    worker_state.rule_index = check;
+    worker_state.line_shifts = large_statement->line_shifts;
+    worker_state.statement_kind = large_statement->statement_kind;
+    worker_state.table_name = large_statement->table_name;
+    worker_state.pattern_matches = large_statement->pattern_matches;
+    {
+      TraceSpan span(rule.name, "rule");
+      PerfCounts start, end;
+      if (perf_counters_enabled) {
+        ReadPerfCounters(start);
+      }
+      rule.check(worker_state, large_statement->statement, print_statement);
+
+      // The checks of the statement count towards the statement as well
+      if (perf_counters_enabled) {
+        ReadPerfCounters(end);
+        AddPerfCounts(check, start, end);
+        AddPerfCounts(GetStatementCounterSlot(), start, end, 0);
+      }
+    }
+    large_statement->check_findings[check].swap(worker_state.findings);
+
+    if (large_statement->remaining_check_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+
+    worker_state.findings.clear();
+    for (auto& check_findings : large_statement->check_findings) {
+      for (auto& finding : check_findings) {
+        worker_state.findings.push_back(std::move(finding));
+      }
+    }
+    finding_cache_.Insert(large_statement->fingerprint, worker_state.findings);
+
+    PrintLargeStatement(worker_state, *large_statement);
+  }
+
+  // Print the findings in worker_state.findings of a large statement
+  void PrintLargeStatement(Configuration& worker_state,
+                           const LargeStatement& large_statement) {
+    std::ostringstream output;
+    std::vector<StatementRecord> records;
+    SetFile(worker_state, large_statement.file_index);
+    worker_state.line_number = large_statement.line_number;
+    Print(worker_state, large_statement.file_index, large_statement.statement,
+          output, records);
+    Write(large_statement.sequence, 1, output.str(), records);
+  }
+
+  // Print the findings, or record them for the deduplicator
+  void Print(Configuration& worker_state,
+             const size_t file_index,
+             const std::string& statement,
+             std::ostringstream& output,
+             std::vector<StatementRecord>& records) {
+    if (worker_state.dedup_mode == false) {
+      PrintFindings(worker_state, statement, output);
+      return;
+    }
+    if (worker_state.findings.empty()) {
+      return;
+    }
+
+    std::ostringstream findings;
+    PrintFindings(worker_state, statement, findings, false);
+
+    StatementRecord record;
+    record.file_index = file_index;
+    record.fingerprint = HashIgnoringCase(statement);
+    record.line_number = worker_state.line_number;
+    record.statement = statement;
+    record.findings = findings.str();
+    records.push_back(std::move(record));
+  }
+
+  // Findings are printed with the name of the file of the statement
+  void SetFile(Configuration& worker_state, const size_t file_index) {
+    worker_state.file_index = file_index;
+    if (worker_state.file_names.empty() == false &&
+        worker_state.file_name != worker_state.file_names[file_index]) {
+      worker_state.file_name = worker_state.file_names[file_index];
+    }
+  }
+
+  void Write(const std::uint64_t sequence,
+             const size_t count,
+             std::string text,
+             std::vector<StatementRecord>& records) {
+    // Checked in order on the splitter thread
+    if (single_thread_output_ != nullptr) {
+      TraceSpan span("write");
+      if (single_thread_deduplicator_ != nullptr) {
+        single_thread_deduplicator_->Add(records);
+      }
+      else {
+        single_thread_output_->write(text.data(), text.size());
+      }
+      written_sequence_.store(sequence + count, std::memory_order_release);
+      return;
+    }
+
+    StatementOutput statement_output;
+    statement_output.sequence = sequence;
+    statement_output.count = count;
+    statement_output.text.swap(text);
+    statement_output.records.swap(records);
+    outputs_.Push(std::move(statement_output));
+  }
+
+  // configuration of each worker
+  std::vector<Configuration> worker_states_;
+
+  BoundedQueue<StatementOutput>& outputs_;
+
+  std::atomic<std::uint64_t>& written_sequence_;
+
+  std::ostream* single_thread_output_;
+
+  StatementDeduplicator* single_thread_deduplicator_;
+
+  // findings of the statements checked so far, in any file
+  FindingCache finding_cache_;
+
+  // declared last, so that the workers stop before the rest is destroyed
+  TaskScheduler scheduler_;
+};
+
+// SPLITTER
+
+class StatementSplitter {
+ public:
+  StatementSplitter(Configuration& state,
+                    StatementChecker& checker,
+                    const std::atomic<std::uint64_t>& written_sequence)
+ : state_(state),
+   checker_(checker),
+   written_sequence_(written_sequence),
+   machine_(state.delimiter[0], state.backslash_escapes),
+   split_state_(SPLIT_STATE_NORMAL),
+   sequence_(0),
+   file_index_(0),
+   line_number_(1),
+   done_(false){
+  }
+
+  // Start splitting another file
+  void StartFile(const size_t file_index) {
+    file_index_ = file_index;
+    split_state_ = SPLIT_STATE_NORMAL;
+    line_number_ = 1;
+    fragment_.clear();
+    done_ = false;
+  }
+
+  // Split a chunk, returns false once no more input is needed
+  bool Split(const InputChunk& chunk) {
+    TraceSpan span("split");
+    std::uint32_t line_count;
+    delimiters_.clear();
+    split_state_ = machine_.Scan(chunk.data, chunk.size, split_state_,
+                                 delimiters_, line_count);
+
+    size_t offset = 0;
+    for (const auto& delimiter : delimiters_) {
+      fragment_.append(chunk.data + offset, delimiter.offset - offset);
+      EmitFragment(static_cast<std::uint32_t>(
+          std::count(fragment_.begin(), fragment_.end(), '\n')));
+      offset = delimiter.offset + 1;
+      if (done_ == true) {
+        return false;
+      }
+    }
+    fragment_.append(chunk.data + offset, chunk.size - offset);
+
+    // Do not hold back statements while waiting for more input
+    FlushBatch();
+
+    return true;
+  }
+
+  // Split the whole input in segments, each scanned by several threads
+  void SplitInput(const char* data, const size_t size) {
+    TraceSpan span("split");
+    std::uint32_t segment_line = 0;
+
+    for (size_t segment = 0; segment < size && done_ == false; segment += kSegmentSize) {
+      auto segment_size = std::min(kSegmentSize, size - segment);
+      std::uint32_t line_count;
+      delimiters_.clear();
+      split_state_ = FindDelimiters(machine_, data + segment, segment_size, split_state_,
+                                    state_.thread_count, delimiters_, line_count);
+
+      size_t offset = 0;
+      for (const auto& delimiter : delimiters_) {
+        fragment_.append(data + segment + offset, delimiter.offset - offset);
+        EmitFragment(1 + segment_line + delimiter.line - line_number_);
+        offset = delimiter.offset + 1;
+        if (done_ == true) {
+          return;
+        }
+      }
+      fragment_.append(data + segment + offset, segment_size - offset);
+
+      segment_line += line_count;
+    }
+  }
+
+  // Emit the last fragment of the file, which is not followed by a delimiter
+  void FinishFile() {
+    if (done_ == false) {
+      EmitFragment(static_cast<std::uint32_t>(
+          std::count(fragment_.begin(), fragment_.end(), '\n')));
+    }
+  }
+
+  // Hand the remaining statements to the checker
+  void Finish() {
+    FlushBatch();
+  }
+
+ private:
+
+  void EmitFragment(const std::uint32_t fragment_lines) {
+
+    if (state_.changed_lines_mode == true && IsChanged() == false) {
+      line_number_ += fragment_lines;
+      fragment_.clear();
+      return;
+    }
+
+    Statement statement;
+    statement.file_index = file_index_;
+    statement.line_number = line_number_;
+    statement.text.swap(fragment_);
+    if (statement.text.empty() == false) {
+      statement.text += " ";
+    }
+    line_number_ += fragment_lines;
+
+    auto sequence = sequence_++;
+
+    // Do not run further ahead of the writer than it can reorder
+    if (sequence - written_sequence_.load(std::memory_order_acquire) >= kStatementWindow) {
+      FlushBatch();
+      TraceSpan span("wait for writer");
+      size_t attempts = 0;
+      while (sequence - written_sequence_.load(std::memory_order_acquire) >= kStatementWindow) {
+        QueueBackoff(attempts);
+      }
+    }
+
+    if (statement.text.size() >= kLargeStatementSize) {
+      FlushBatch();
+      checker_.CheckLargeStatement(sequence, statement);
+    }
+    else {
+      if (batch_ == nullptr) {
+        batch_.reset(new StatementBatch());
+        batch_->first_sequence = sequence;
+      }
+      batch_->size += statement.text.size();
+      batch_->statements.push_back(std::move(statement));
+
+      if (batch_->statements.size() >= kBatchStatementCount || batch_->size >= kBatchSize) {
+        FlushBatch();
+      }
+    }
+
+    fragment_.clear();
+  }
+
+  void FlushBatch() {
+    if (batch_ != nullptr) {
+      checker_.CheckBatch(batch_);
+      batch_.reset();
+    }
+  }
+
+  // Whether the fragment overlaps the changed lines
+  bool IsChanged() {
+
+    // Leading line breaks belong to the previous statement's line
+    auto first_text = fragment_.find_first_not_of(" \t\r\n");
+    if (first_text == std::string::npos) {
+      first_text = fragment_.size();
+    }
+    auto first_line = line_number_ + static_cast<std::uint32_t>(
+        std::count(fragment_.begin(), fragment_.begin() + first_text, '\n'));
+    auto last_line = first_line + static_cast<std::uint32_t>(
+        std::count(fragment_.begin() + first_text, fragment_.end(), '\n'));
+
+    // Stop reading once past the last changed line
+    const auto& changed_lines = GetChangedLines();
+    if (changed_lines.empty() || first_line > changed_lines.back().second) {
+      done_ = true;
+      return false;
+    }
+
+    return OverlapsLineRanges(changed_lines, first_line, last_line);
+  }
+
+  // Changed lines of the file being split
+  const LineRanges& GetChangedLines() const {
+    if (file_index_ >= state_.file_changed_lines.size()) {
+      return state_.changed_lines;
+    }
+    return state_.file_changed_lines[file_index_];
+  }
+
+  Configuration& state_;
+
+  StatementChecker& checker_;
+
+  const std::atomic<std::uint64_t>& written_sequence_;
+
+  // finds the delimiters outside of strings and comments
+  const SplitMachine machine_;
+
+  // state at the end of the input split so far
+  SplitState split_state_;
+
+  // delimiters of the chunk or segment being split
+  std::vector<SplitDelimiter> delimiters_;
+
+  // next statement sequence
+  std::uint64_t sequence_;
+
+  // index of the file being split
+  size_t file_index_;
+
+  // line of the first byte of the fragment
+  std::uint32_t line_number_;
+
+  // statement text read so far
+  std::string fragment_;
+
+  // statements not yet handed to the checker
+  std::shared_ptr<StatementBatch> batch_;
+
+  // past the last changed line
+  bool done_;
+};
+
+// WRITER
+
+void RunWriter(BoundedQueue<StatementOutput>& outputs,
+               std::atomic<std::uint64_t>& written_sequence,
+               std::ostream& output,
+               StatementDeduplicator* deduplicator){
+
+  SetTraceThreadName("writer");
+
+  // Outputs that arrived ahead of their turn, indexed by first sequence
+  std::vector<std::string> pending(kStatementWindow);
+  std::vector<std::vector<StatementRecord>> pending_records(kStatementWindow);
+  std::vector<size_t> pending_count(kStatementWindow, 0);
+
+  std::uint64_t next_sequence = 0;
+  StatementOutput statement_output;
+
+  while (true) {
+    outputs.Pop(statement_output);
+
+    if (statement_output.end_of_input == true) {
+      break;
+    }
+
+    auto slot = statement_output.sequence % kStatementWindow;
+    pending[slot].swap(statement_output.text);
+    pending_records[slot].swap(statement_output.records);
+    pending_count[slot] = statement_output.count;
+
+    // Write every output that is now in order
+    TraceSpan span("write");
+    while (true) {
+      auto next_slot = next_sequence % kStatementWindow;
+      if (pending_count[next_slot] == 0) {
+        break;
+      }
+      if (deduplicator != nullptr) {
+        deduplicator->Add(pending_records[next_slot]);
+        pending_records[next_slot].clear();
+      }
+      else {
+        output.write(pending[next_slot].data(), pending[next_slot].size());
+      }
+      pending[next_slot].clear();
+      next_sequence += pending_count[next_slot];
+      pending_count[next_slot] = 0;
+    }
+
+    written_sequence.store(next_sequence, std::memory_order_release);
+  }
+
+  if (deduplicator != nullptr) {
+    deduplicator->Finish();
+  }
+  output.flush();
+}
+
+// Split the files of a reader that keeps several reads in flight
+void ReadFilesAndSplit(Configuration& state, StatementSplitter& splitter){
+
+  auto reader = OpenFileReader(state.file_names, kFileQueueDepth);
+  FileData file;
+
+  while (true) {
+    {
+      TraceSpan span("read");
+      if (reader->Next(file) == false) {
+        break;
+      }
+    }
+    if (file.error != 0) {
+      std::cerr << "Could not read " << state.file_names[file.index] << ": "
+          << strerror(file.error) << "\n";
+      continue;
+    }
+
+    splitter.StartFile(file.index);
+    splitter.SplitInput(file.data.data(), file.data.size());
+    splitter.FinishFile();
+  }
+
+}
+
+// Split the chunks of a reader thread, after the chunk already read
+void ReadAndSplit(InputReader& reader,
+                  std::unique_ptr<InputChunk> first_chunk,
+                  StatementSplitter& splitter){
+
+  BoundedQueue<std::unique_ptr<InputChunk>> chunks(kChunkQueueCapacity);
+  std::atomic<bool> stop_reading(first_chunk == nullptr);
+
+  // Reader: an empty chunk marks the end of the input
+  std::thread reader_thread([&]() {
+    SetTraceThreadName("reader");
+    while (stop_reading.load(std::memory_order_relaxed) == false) {
+      std::unique_ptr<InputChunk> chunk;
+      {
+        TraceSpan span("read");
+        chunk = reader.Read();
+      }
+      if (chunk == nullptr) {
+        break;
+      }
+      chunks.Push(std::move(chunk));
+    }
+    chunks.Push(std::unique_ptr<InputChunk>());
+  });
+
+  bool splitting = (first_chunk != nullptr);
+  if (splitting && splitter.Split(*first_chunk) == false) {
+    splitting = false;
+    stop_reading.store(true, std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<InputChunk> chunk;
+  while (true) {
+    chunks.Pop(chunk);
+    if (chunk == nullptr) {
+      break;
+    }
+    if (splitting && splitter.Split(*chunk) == false) {
+      // Drain the reader
+      splitting = false;
+      stop_reading.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  reader_thread.join();
+}
+
+}  // namespace
+
+void RunPipeline(Configuration& state, std::ostream& output){
+
+  SetTraceThreadName("splitter");
+
+  // Open the input, small inputs that are read at once are checked on this
+  // thread, without starting the reader, the writer and the workers
+  bool single_thread = false;
+  std::unique_ptr<std::istream> stream;
+  std::unique_ptr<InputReader> reader;
+  std::unique_ptr<InputChunk> first_chunk;
+
+#ifdef SQLCHECK_HAVE_POSIX_IO
+  // Regular files are mapped and split in parallel
+  MappedFile mapped_file;
+  bool mapped = false;
+  if (state.file_names.empty() && state.testing_mode == false &&
+      state.file_name.empty() == false && mapped_file.Open(state.file_name)) {
+    mapped = true;
+    single_thread = (mapped_file.GetSize() <= kSingleThreadInputSize);
+  }
+#else
+  bool mapped = false;
+#endif
+
+  if (state.file_names.empty() && mapped == false) {
+    reader = OpenInput(state, stream);
+    {
+      TraceSpan span("read");
+      first_chunk = reader->Read();
+    }
+    single_thread = (first_chunk == nullptr) ||
+        (reader->AtEnd() && first_chunk->size <= kSingleThreadInputSize);
+  }
+
+  BoundedQueue<StatementOutput> outputs(single_thread ? 1 : kOutputQueueCapacity);
+  std::atomic<std::uint64_t> written_sequence(0);
+
+  std::unique_ptr<StatementDeduplicator> deduplicator;
+  if (state.dedup_mode == true) {
+    deduplicator.reset(new StatementDeduplicator(state, output));
+  }
+
+  // Writer
+  std::thread writer_thread;
+  if (single_thread == false) {
+    writer_thread = std::thread(RunWriter,
+                                std::ref(outputs),
+                                std::ref(written_sequence),
+                                std::ref(output),
+                                deduplicator.get());
+  }
+
+  // Splitter, feeding the checkers
+  StatementChecker checker(state, outputs, written_sequence,
+                           single_thread ? &output : nullptr,
+                           single_thread ? deduplicator.get() : nullptr);
+  StatementSplitter splitter(state, checker, written_sequence);
+
+  if (state.file_names.empty() == false) {
+    ReadFilesAndSplit(state, splitter);
+  }
+#ifdef SQLCHECK_HAVE_POSIX_IO
+  else if (mapped == true) {
+    splitter.SplitInput(mapped_file.GetData(), mapped_file.GetSize());
+    splitter.FinishFile();
+  }
+#endif
+  else if (single_thread == true) {
+    if (first_chunk != nullptr) {
+      splitter.Split(*first_chunk);
+    }
+    splitter.FinishFile();
+  }
+  else {
+    ReadAndSplit(*reader, std::move(first_chunk), splitter);
+    splitter.FinishFile();
+  }
+  splitter.Finish();
+
+  checker.Finish(state);
+
+  if (single_thread == true) {
+    if (deduplicator != nullptr) {
+      deduplicator->Finish();
+    }
+    output.flush();
+    return;
+  }
+
+  StatementOutput end_of_input;
+  end_of_input.end_of_input = true;
+  outputs.Push(std::move(end_of_input));
+  writer_thread.join();
+
+}
+
+}  // namespace sqlcheck
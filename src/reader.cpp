@@ -0,0 +1,659 @@
+// READER SOURCE
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SQLCHECK_HAVE_POSIX_IO 1
+#endif
+
+#ifdef SQLCHECK_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "include/reader.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Threads of the pread pool
+const size_t kMaxReadThreads = 16;
+
+// Largest single read request
+const size_t kMaxReadSize = 1 << 30;
+
+#ifdef SQLCHECK_HAVE_POSIX_IO
+
+void ReadFile(const std::string& file_name, FileData& file){
+
+  int descriptor;
+  do {
+    descriptor = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  } while (descriptor < 0 && errno == EINTR);
+
+  if (descriptor < 0) {
+    file.error = errno;
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(descriptor, &file_stat) != 0) {
+    file.error = errno;
+    close(descriptor);
+    return;
+  }
+
+  file.data.resize(static_cast<size_t>(file_stat.st_size));
+  size_t offset = 0;
+  while (offset < file.data.size()) {
+    auto bytes_read = pread(descriptor, &file.data[offset],
+                            std::min(kMaxReadSize, file.data.size() - offset),
+                            static_cast<off_t>(offset));
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes_read < 0) {
+      file.error = errno;
+      break;
+    }
+    if (bytes_read == 0) {
+      // Truncated since fstat
+      file.data.resize(offset);
+      break;
+    }
+    offset += static_cast<size_t>(bytes_read);
+  }
+
+  close(descriptor);
+}
+
+#else
+
+void ReadFile(const std::string& file_name, FileData& file){
+  std::ifstream input(file_name.c_str(), std::ios::binary);
+  if (input.good() == false) {
+    file.error = ENOENT;
+    return;
+  }
+  std::ostringstream data;
+  data << input.rdbuf();
+  file.data = data.str();
+}
+
+#endif
+
+// Reads the files on a pool of threads, each doing blocking open and pread
+class ThreadPoolFileReader : public FileReader {
+ public:
+  ThreadPoolFileReader(const std::vector<std::string>& file_names,
+                       const size_t queue_depth)
+ : file_names_(file_names),
+   slots_(std::max<size_t>(queue_depth, 1)),
+   next_index_(0),
+   claimed_index_(0),
+   stop_(false){
+    auto thread_count = std::min(std::min(kMaxReadThreads, slots_.size()), file_names_.size());
+    for (size_t i = 0; i < thread_count; i++) {
+      threads_.push_back(std::thread(&ThreadPoolFileReader::RunReader, this));
+    }
+  }
+
+  ~ThreadPoolFileReader() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    space_available_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  bool Next(FileData& file) {
+    if (next_index_ >= file_names_.size()) {
+      return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& slot = slots_[next_index_ % slots_.size()];
+    file_ready_.wait(lock, [&slot]() { return slot.ready; });
+
+    file = std::move(slot.file);
+    slot.ready = false;
+    next_index_++;
+    lock.unlock();
+
+    space_available_.notify_all();
+    return true;
+  }
+
+ private:
+
+  struct Slot {
+    Slot()
+     : ready(false) {
+    }
+
+    FileData file;
+    bool ready;
+  };
+
+  void RunReader() {
+    while (true) {
+      size_t index;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_available_.wait(lock, [this]() {
+          return stop_ || claimed_index_ >= file_names_.size() ||
+              claimed_index_ < next_index_ + slots_.size();
+        });
+        if (stop_ || claimed_index_ >= file_names_.size()) {
+          return;
+        }
+        index = claimed_index_++;
+      }
+
+      FileData file;
+      file.index = index;
+      ReadFile(file_names_[index], file);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = slots_[index % slots_.size()];
+        slot.file = std::move(file);
+        slot.ready = true;
+      }
+      file_ready_.notify_all();
+    }
+  }
+
+  const std::vector<std::string>& file_names_;
+
+  // files in flight, indexed by file index
+  std::vector<Slot> slots_;
+
+  // next file handed out
+  size_t next_index_;
+
+  // next file to read
+  size_t claimed_index_;
+
+  bool stop_;
+
+  std::mutex mutex_;
+  std::condition_variable file_ready_;
+  std::condition_variable space_available_;
+
+  std::vector<std::thread> threads_;
+};
+
+#ifdef SQLCHECK_HAVE_IO_URING
+
+// Reads the files with io_uring: opens and reads of up to queue_depth files
+// are in flight at once, without a thread per request
+class IoUringFileReader : public FileReader {
+ public:
+  IoUringFileReader(const std::vector<std::string>& file_names,
+                    const size_t queue_depth)
+ : file_names_(file_names),
+   requests_(std::max<size_t>(queue_depth, 1)),
+   ring_descriptor_(-1),
+   sq_ring_(nullptr),
+   sq_ring_size_(0),
+   cq_ring_(nullptr),
+   cq_ring_size_(0),
+   sqes_(nullptr),
+   sqes_size_(0),
+   next_index_(0),
+   submitted_index_(0),
+   pending_submission_count_(0),
+   in_flight_count_(0),
+   draining_(false){
+  }
+
+  ~IoUringFileReader() {
+    // The kernel may still write into the buffers of requests in flight
+    draining_ = true;
+    while (in_flight_count_ > 0) {
+      if (Enter(1) == false) {
+        break;
+      }
+      ReapCompletions();
+    }
+
+    for (auto& request : requests_) {
+      if (request.descriptor >= 0) {
+        close(request.descriptor);
+      }
+    }
+
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_descriptor_ >= 0) {
+      close(ring_descriptor_);
+    }
+  }
+
+  // Set up the ring, returns false if io_uring or its operations are unavailable
+  bool Open() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_descriptor_ = static_cast<int>(syscall(__NR_io_uring_setup,
+                                                static_cast<unsigned>(requests_.size()),
+                                                &params));
+    if (ring_descriptor_ < 0) {
+      return false;
+    }
+
+    // Opens and reads as ring operations need Linux 5.6
+    if (IsSupported(IORING_OP_OPENAT) == false || IsSupported(IORING_OP_READ) == false) {
+      return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == nullptr) {
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_ : Map(cq_ring_size_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == nullptr) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = Map(sqes_size_, IORING_OFF_SQES);
+    if (sqes_ == nullptr) {
+      return false;
+    }
+
+    auto sq_ring = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+
+    auto cq_ring = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+    return true;
+  }
+
+  bool Next(FileData& file) {
+    if (next_index_ >= file_names_.size()) {
+      return false;
+    }
+
+    auto& request = requests_[next_index_ % requests_.size()];
+    while (true) {
+      // Keep the window of files in flight full
+      while (submitted_index_ < file_names_.size() &&
+             submitted_index_ < next_index_ + requests_.size()) {
+        SubmitOpen(submitted_index_++);
+      }
+
+      if (request.done == true) {
+        break;
+      }
+
+      if (Enter(1) == false) {
+        throw std::runtime_error(std::string("io_uring_enter: ") + strerror(errno));
+      }
+      ReapCompletions();
+    }
+
+    file = std::move(request.file);
+    request.done = false;
+    next_index_++;
+    return true;
+  }
+
+ private:
+
+  // Open or read of a file
+  struct Request {
+    Request()
+     : descriptor(-1),
+       offset(0),
+       done(false) {
+    }
+
+    FileData file;
+
+    // open file, -1 while opening
+    int descriptor;
+
+    // bytes read so far
+    size_t offset;
+
+    bool done;
+  };
+
+  bool IsSupported(const int operation) {
+    std::vector<char> buffer(sizeof(struct io_uring_probe) +
+                             256 * sizeof(struct io_uring_probe_op), 0);
+    auto probe = reinterpret_cast<struct io_uring_probe*>(buffer.data());
+    if (syscall(__NR_io_uring_register, ring_descriptor_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+      return false;
+    }
+    return operation <= probe->last_op &&
+        (probe->ops[operation].flags & IO_URING_OP_SUPPORTED) != 0;
+  }
+
+  void* Map(const size_t size, const off_t offset) {
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_descriptor_, offset);
+    return (data == MAP_FAILED) ? nullptr : data;
+  }
+
+  void Push(const struct io_uring_sqe& sqe) {
+    // Only this thread produces submissions
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    static_cast<struct io_uring_sqe*>(sqes_)[index] = sqe;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    pending_submission_count_++;
+    in_flight_count_++;
+  }
+
+  void SubmitOpen(const size_t index) {
+    auto& request = requests_[index % requests_.size()];
+    request.file = FileData();
+    request.file.index = index;
+    request.descriptor = -1;
+    request.offset = 0;
+    request.done = false;
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_OPENAT;
+    sqe.fd = AT_FDCWD;
+    sqe.addr = reinterpret_cast<std::uint64_t>(file_names_[index].c_str());
+    sqe.open_flags = O_RDONLY | O_CLOEXEC;
+    sqe.user_data = index % requests_.size();
+    Push(sqe);
+  }
+
+  void SubmitRead(const size_t slot) {
+    auto& request = requests_[slot];
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = request.descriptor;
+    sqe.addr = reinterpret_cast<std::uint64_t>(&request.file.data[request.offset]);
+    sqe.len = static_cast<unsigned>(std::min(kMaxReadSize,
+                                             request.file.data.size() - request.offset));
+    sqe.off = request.offset;
+    sqe.user_data = slot;
+    Push(sqe);
+  }
+
+  void Finish(Request& request, const int error) {
+    request.file.error = error;
+    if (request.descriptor >= 0) {
+      close(request.descriptor);
+      request.descriptor = -1;
+    }
+    request.done = true;
+  }
+
+  void Complete(const size_t slot, const int result) {
+    auto& request = requests_[slot];
+
+    if (draining_ == true) {
+      // An open that succeeded returned a descriptor the request does not
+      // hold yet
+      if (request.descriptor < 0 && result >= 0) {
+        close(result);
+      }
+      Finish(request, ECANCELED);
+      return;
+    }
+
+    // Open
+    if (request.descriptor < 0) {
+      if (result < 0) {
+        Finish(request, -result);
+        return;
+      }
+      request.descriptor = result;
+
+      struct stat file_stat;
+      if (fstat(request.descriptor, &file_stat) != 0) {
+        Finish(request, errno);
+        return;
+      }
+      request.file.data.resize(static_cast<size_t>(file_stat.st_size));
+      if (request.file.data.empty()) {
+        Finish(request, 0);
+        return;
+      }
+      SubmitRead(slot);
+      return;
+    }
+
+    // Read
+    if (result == -EINTR || result == -EAGAIN) {
+      SubmitRead(slot);
+      return;
+    }
+    if (result < 0) {
+      Finish(request, -result);
+      return;
+    }
+    if (result == 0) {
+      // Truncated since fstat
+      request.file.data.resize(request.offset);
+      Finish(request, 0);
+      return;
+    }
+
+    request.offset += static_cast<size_t>(result);
+    if (request.offset < request.file.data.size()) {
+      SubmitRead(slot);
+      return;
+    }
+    Finish(request, 0);
+  }
+
+  // Submit the pending requests and wait for completions
+  bool Enter(const unsigned min_complete) {
+    while (true) {
+      auto submitted = syscall(__NR_io_uring_enter, ring_descriptor_,
+                               pending_submission_count_, min_complete,
+                               IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (submitted >= 0) {
+        pending_submission_count_ -= static_cast<unsigned>(submitted);
+        return true;
+      }
+      if (errno != EINTR) {
+        return false;
+      }
+    }
+  }
+
+  void ReapCompletions() {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+      auto& cqe = cqes_[head & cq_mask_];
+      in_flight_count_--;
+      Complete(static_cast<size_t>(cqe.user_data), cqe.res);
+      head++;
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  const std::vector<std::string>& file_names_;
+
+  // requests of the files in flight, indexed by file index
+  std::vector<Request> requests_;
+
+  // ring
+  int ring_descriptor_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  void* sqes_;
+  size_t sqes_size_;
+
+  // submission queue
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+
+  // completion queue
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  struct io_uring_cqe* cqes_;
+
+  // next file handed out
+  size_t next_index_;
+
+  // next file to open
+  size_t submitted_index_;
+
+  // requests not yet passed to the kernel
+  unsigned pending_submission_count_;
+
+  // requests not yet completed
+  size_t in_flight_count_;
+
+  // completing the requests in flight before destruction
+  bool draining_;
+};
+
+#endif
+
+#ifdef SQLCHECK_HAVE_POSIX_IO
+
+bool EndsWith(const std::string& text, const std::string& suffix){
+  return text.size() >= suffix.size() &&
+      text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void CollectDirectoryFiles(const std::string& directory,
+                           std::vector<std::string>& file_names){
+
+  DIR* stream = opendir(directory.c_str());
+  if (stream == nullptr) {
+    return;
+  }
+
+  std::vector<std::string> entries;
+  while (auto entry = readdir(stream)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      entries.push_back(name);
+    }
+  }
+  closedir(stream);
+  std::sort(entries.begin(), entries.end());
+
+  for (const auto& name : entries) {
+    auto path = EndsWith(directory, "/") ? directory + name : directory + "/" + name;
+    struct stat path_stat;
+    if (lstat(path.c_str(), &path_stat) != 0) {
+      continue;
+    }
+
+    // Links to files are followed, links to directories are not, as they
+    // may lead back to a parent
+    bool is_link = S_ISLNK(path_stat.st_mode);
+    if (is_link && stat(path.c_str(), &path_stat) != 0) {
+      continue;
+    }
+    if (S_ISDIR(path_stat.st_mode)) {
+      if (is_link == false) {
+        CollectDirectoryFiles(path, file_names);
+      }
+    }
+    else if (S_ISREG(path_stat.st_mode) && EndsWith(name, ".sql")) {
+      file_names.push_back(path);
+    }
+  }
+
+}
+
+#endif
+
+}  // namespace
+
+std::unique_ptr<FileReader> OpenFileReader(const std::vector<std::string>& file_names,
+                                           const size_t queue_depth,
+                                           const bool use_io_uring){
+
+#ifdef SQLCHECK_HAVE_IO_URING
+  if (use_io_uring == true) {
+    std::unique_ptr<IoUringFileReader> io_uring_reader(new IoUringFileReader(file_names,
+                                                                             queue_depth));
+    if (io_uring_reader->Open()) {
+      return std::unique_ptr<FileReader>(io_uring_reader.release());
+    }
+  }
+#else
+  (void) use_io_uring;
+#endif
+
+  return std::unique_ptr<FileReader>(new ThreadPoolFileReader(file_names, queue_depth));
+}
+
+bool CollectInputFiles(const std::string& path,
+                       std::vector<std::string>& file_names){
+
+#ifdef SQLCHECK_HAVE_POSIX_IO
+  struct stat path_stat;
+  if (stat(path.c_str(), &path_stat) != 0) {
+    return false;
+  }
+  if (S_ISDIR(path_stat.st_mode)) {
+    CollectDirectoryFiles(path, file_names);
+    return true;
+  }
+#else
+  std::ifstream input(path.c_str());
+  if (input.good() == false) {
+    return false;
+  }
+#endif
+
+  file_names.push_back(path);
+  return true;
+}
+
+}  // namespace sqlcheck
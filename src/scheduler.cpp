@@ -0,0 +1,134 @@
+// SCHEDULER SOURCE
+
+#include "include/scheduler.h"
+#include "include/queue.h"
+#include "include/trace.h"
+
+namespace sqlcheck {
+
+TaskScheduler::TaskScheduler(size_t worker_count)
+ : pending_task_count_(0),
+   finishing_(false),
+   next_queue_(0),
+   steal_count_(0){
+
+  for (size_t i = 0; i < worker_count; i++) {
+    queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+  }
+
+  for (size_t i = 0; i < worker_count; i++) {
+    threads_.push_back(std::thread(&TaskScheduler::RunWorker, this, i));
+  }
+
+}
+
+TaskScheduler::~TaskScheduler(){
+  Finish();
+}
+
+void TaskScheduler::Submit(Task task){
+  if (queues_.empty()) {
+    task(0);
+    return;
+  }
+
+  auto worker = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+  Push(worker, std::move(task), false);
+}
+
+void TaskScheduler::Spawn(size_t worker, Task task){
+  if (queues_.empty()) {
+    task(worker);
+    return;
+  }
+
+  Push(worker, std::move(task), true);
+}
+
+void TaskScheduler::Finish(){
+  finishing_.store(true, std::memory_order_release);
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void TaskScheduler::Push(size_t worker, Task task, const bool spawned){
+  // Count the task before it can be taken
+  pending_task_count_.fetch_add(1, std::memory_order_acq_rel);
+
+  auto& queue = *queues_[worker];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (spawned) {
+    queue.spawned_tasks.push_back(std::move(task));
+  }
+  else {
+    queue.submitted_tasks.push_back(std::move(task));
+  }
+}
+
+bool TaskScheduler::TakeTask(size_t worker, Task& task){
+
+  // Newest task spawned on us, while its data is still in cache, then our
+  // oldest submitted task: the writer waits for the oldest batch, newer ones
+  // would only fill its window
+  {
+    auto& queue = *queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.spawned_tasks.empty() == false) {
+      task = std::move(queue.spawned_tasks.back());
+      queue.spawned_tasks.pop_back();
+      return true;
+    }
+    if (queue.submitted_tasks.empty() == false) {
+      task = std::move(queue.submitted_tasks.front());
+      queue.submitted_tasks.pop_front();
+      return true;
+    }
+  }
+
+  // Oldest task of another worker, spawned tasks first to finish the
+  // statements in flight
+  for (size_t i = 1; i < queues_.size(); i++) {
+    auto& queue = *queues_[(worker + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto& tasks = queue.spawned_tasks.empty() ? queue.submitted_tasks : queue.spawned_tasks;
+    if (tasks.empty() == false) {
+      task = std::move(tasks.front());
+      tasks.pop_front();
+      steal_count_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TaskScheduler::RunWorker(size_t worker){
+
+  SetTraceThreadName("worker " + std::to_string(worker));
+  Task task;
+  size_t attempts = 0;
+
+  while (true) {
+    if (TakeTask(worker, task)) {
+      task(worker);
+      task = nullptr;
+      // Tasks spawned by the task were counted before this
+      pending_task_count_.fetch_sub(1, std::memory_order_acq_rel);
+      attempts = 0;
+      continue;
+    }
+
+    if (finishing_.load(std::memory_order_acquire) == true &&
+        pending_task_count_.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+
+    QueueBackoff(attempts);
+  }
+
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,261 @@
+// SPLITTER SOURCE
+
+#include <algorithm>
+#include <thread>
+
+#include "include/splitter.h"
+#include "include/trace.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Set on transitions that end a statement
+const std::uint8_t kDelimiterBit = 0x80;
+
+// Chunks scanned by a thread are at least this large
+const size_t kMinChunkSize = 1 << 20;
+
+// Lanes of the speculative scan are merged after each block
+const size_t kTransitionBlockSize = 256;
+
+SplitState NormalTransition(const unsigned char c){
+  switch (c) {
+    case '\'':
+      return SPLIT_STATE_SINGLE_QUOTE;
+    case '"':
+      return SPLIT_STATE_DOUBLE_QUOTE;
+    case '`':
+      return SPLIT_STATE_BACKTICK;
+    case '-':
+      return SPLIT_STATE_DASH;
+    case '/':
+      return SPLIT_STATE_SLASH;
+    default:
+      return SPLIT_STATE_NORMAL;
+  }
+}
+
+SplitState Transition(const SplitState state, const unsigned char c,
+                      const bool backslash_escapes){
+  switch (state) {
+    case SPLIT_STATE_DASH:
+      return (c == '-') ? SPLIT_STATE_LINE_COMMENT : NormalTransition(c);
+    case SPLIT_STATE_SLASH:
+      return (c == '*') ? SPLIT_STATE_BLOCK_COMMENT : NormalTransition(c);
+
+    case SPLIT_STATE_SINGLE_QUOTE:
+      if (backslash_escapes && c == '\\') {
+        return SPLIT_STATE_SINGLE_QUOTE_ESCAPE;
+      }
+      return (c == '\'') ? SPLIT_STATE_NORMAL : SPLIT_STATE_SINGLE_QUOTE;
+    case SPLIT_STATE_SINGLE_QUOTE_ESCAPE:
+      return SPLIT_STATE_SINGLE_QUOTE;
+
+    case SPLIT_STATE_DOUBLE_QUOTE:
+      if (backslash_escapes && c == '\\') {
+        return SPLIT_STATE_DOUBLE_QUOTE_ESCAPE;
+      }
+      return (c == '"') ? SPLIT_STATE_NORMAL : SPLIT_STATE_DOUBLE_QUOTE;
+    case SPLIT_STATE_DOUBLE_QUOTE_ESCAPE:
+      return SPLIT_STATE_DOUBLE_QUOTE;
+
+    case SPLIT_STATE_BACKTICK:
+      return (c == '`') ? SPLIT_STATE_NORMAL : SPLIT_STATE_BACKTICK;
+
+    case SPLIT_STATE_LINE_COMMENT:
+      return (c == '\n') ? SPLIT_STATE_NORMAL : SPLIT_STATE_LINE_COMMENT;
+    case SPLIT_STATE_BLOCK_COMMENT:
+      return (c == '*') ? SPLIT_STATE_BLOCK_COMMENT_STAR : SPLIT_STATE_BLOCK_COMMENT;
+    case SPLIT_STATE_BLOCK_COMMENT_STAR:
+      if (c == '/') {
+        return SPLIT_STATE_NORMAL;
+      }
+      return (c == '*') ? SPLIT_STATE_BLOCK_COMMENT_STAR : SPLIT_STATE_BLOCK_COMMENT;
+
+    default:
+      return NormalTransition(c);
+  }
+}
+
+bool IsCodeState(const SplitState state){
+  return state == SPLIT_STATE_NORMAL ||
+      state == SPLIT_STATE_DASH ||
+      state == SPLIT_STATE_SLASH;
+}
+
+}  // namespace
+
+SplitMachine::SplitMachine(const char delimiter, const bool backslash_escapes){
+
+  for (int state = 0; state < SPLIT_STATE_COUNT; state++) {
+    for (int c = 0; c < 256; c++) {
+      auto split_state = static_cast<SplitState>(state);
+      auto byte = static_cast<unsigned char>(c);
+
+      if (IsCodeState(split_state) && byte == static_cast<unsigned char>(delimiter)) {
+        transitions_[state][c] = SPLIT_STATE_NORMAL | kDelimiterBit;
+      }
+      else {
+        transitions_[state][c] = static_cast<std::uint8_t>(Transition(split_state, byte,
+                                                                     backslash_escapes));
+      }
+    }
+  }
+
+}
+
+SplitState SplitMachine::Scan(const char* data,
+                              const size_t size,
+                              const SplitState state,
+                              std::vector<SplitDelimiter>& delimiters,
+                              std::uint32_t& line_count) const {
+
+  std::uint8_t current_state = static_cast<std::uint8_t>(state);
+  std::uint32_t line = 0;
+
+  for (size_t offset = 0; offset < size; offset++) {
+    auto c = static_cast<unsigned char>(data[offset]);
+    auto transition = transitions_[current_state][c];
+    if (transition & kDelimiterBit) {
+      SplitDelimiter delimiter;
+      delimiter.offset = offset;
+      delimiter.line = line;
+      delimiters.push_back(delimiter);
+    }
+    line += (c == '\n');
+    current_state = transition & ~kDelimiterBit;
+  }
+
+  line_count = line;
+  return static_cast<SplitState>(current_state);
+}
+
+void SplitMachine::ScanTransitions(const char* data,
+                                   const size_t size,
+                                   SplitState end_states[SPLIT_STATE_COUNT]) const {
+
+  // Start states that reached the same state scan on as a single lane
+  std::uint8_t lane_states[SPLIT_STATE_COUNT];
+  size_t lane_of_state[SPLIT_STATE_COUNT];
+  size_t lane_count = SPLIT_STATE_COUNT;
+  for (size_t state = 0; state < SPLIT_STATE_COUNT; state++) {
+    lane_states[state] = static_cast<std::uint8_t>(state);
+    lane_of_state[state] = state;
+  }
+
+  for (size_t block = 0; block < size; block += kTransitionBlockSize) {
+    auto block_end = std::min(size, block + kTransitionBlockSize);
+
+    for (size_t lane = 0; lane < lane_count; lane++) {
+      auto current_state = lane_states[lane];
+      for (size_t offset = block; offset < block_end; offset++) {
+        auto c = static_cast<unsigned char>(data[offset]);
+        current_state = transitions_[current_state][c] & ~kDelimiterBit;
+      }
+      lane_states[lane] = current_state;
+    }
+
+    // Merge the lanes that reached the same state
+    size_t merged_lane_of_lane[SPLIT_STATE_COUNT];
+    size_t merged_lane_count = 0;
+    for (size_t lane = 0; lane < lane_count; lane++) {
+      size_t merged_lane = 0;
+      while (merged_lane < merged_lane_count &&
+          lane_states[merged_lane] != lane_states[lane]) {
+        merged_lane++;
+      }
+      if (merged_lane == merged_lane_count) {
+        lane_states[merged_lane_count++] = lane_states[lane];
+      }
+      merged_lane_of_lane[lane] = merged_lane;
+    }
+    for (size_t state = 0; state < SPLIT_STATE_COUNT; state++) {
+      lane_of_state[state] = merged_lane_of_lane[lane_of_state[state]];
+    }
+    lane_count = merged_lane_count;
+  }
+
+  for (size_t state = 0; state < SPLIT_STATE_COUNT; state++) {
+    end_states[state] = static_cast<SplitState>(lane_states[lane_of_state[state]]);
+  }
+
+}
+
+SplitState FindDelimiters(const SplitMachine& machine,
+                          const char* data,
+                          const size_t size,
+                          const SplitState state,
+                          const size_t thread_count,
+                          std::vector<SplitDelimiter>& delimiters,
+                          std::uint32_t& line_count){
+
+  auto chunk_count = std::max<size_t>(1, std::min(thread_count, size / kMinChunkSize));
+  if (chunk_count == 1) {
+    return machine.Scan(data, size, state, delimiters, line_count);
+  }
+
+  auto chunk_size = (size + chunk_count - 1) / chunk_count;
+  std::vector<SplitState> end_states(chunk_count * SPLIT_STATE_COUNT);
+  std::vector<SplitState> start_states(chunk_count + 1);
+  std::vector<std::vector<SplitDelimiter>> chunk_delimiters(chunk_count);
+  std::vector<std::uint32_t> chunk_line_counts(chunk_count, 0);
+  std::vector<std::thread> threads;
+  start_states[0] = state;
+
+  // Scan the first chunk from its known state, and every other chunk from
+  // each possible state
+  threads.push_back(std::thread([&]() {
+    TraceSpan span("scan");
+    start_states[1] = machine.Scan(data, chunk_size, state,
+                                   chunk_delimiters[0], chunk_line_counts[0]);
+  }));
+  for (size_t chunk = 1; chunk < chunk_count; chunk++) {
+    threads.push_back(std::thread([&, chunk]() {
+      TraceSpan span("scan transitions");
+      auto begin = chunk * chunk_size;
+      auto end = std::min(size, begin + chunk_size);
+      machine.ScanTransitions(data + begin, end - begin,
+                              &end_states[chunk * SPLIT_STATE_COUNT]);
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+
+  // Resolve the state at the start of each chunk, in order
+  for (size_t chunk = 1; chunk < chunk_count; chunk++) {
+    start_states[chunk + 1] = end_states[chunk * SPLIT_STATE_COUNT + start_states[chunk]];
+  }
+
+  // Rescan the other chunks from their actual state
+  for (size_t chunk = 1; chunk < chunk_count; chunk++) {
+    threads.push_back(std::thread([&, chunk]() {
+      TraceSpan span("scan");
+      auto begin = chunk * chunk_size;
+      auto end = std::min(size, begin + chunk_size);
+      machine.Scan(data + begin, end - begin, start_states[chunk],
+                   chunk_delimiters[chunk], chunk_line_counts[chunk]);
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Concatenate the delimiters of the chunks
+  std::uint32_t line_base = 0;
+  for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+    for (auto delimiter : chunk_delimiters[chunk]) {
+      delimiter.offset += chunk * chunk_size;
+      delimiter.line += line_base;
+      delimiters.push_back(delimiter);
+    }
+    line_base += chunk_line_counts[chunk];
+  }
+
+  line_count = line_base;
+  return start_states[chunk_count];
+}
+
+}  // namespace sqlcheck
@@ -0,0 +1,95 @@
+// STATS SOURCE
+
+#include <algorithm>
+#include <cmath>
+
+#include "include/stats.h"
+
+namespace sqlcheck {
+
+namespace {
+
+// Two-sided 95% quantile of the normal distribution
+const double kConfidenceZ = 1.96;
+
+double SortedMedian(const std::vector<double>& sorted){
+  auto count = sorted.size();
+  if (count == 0) {
+    return 0;
+  }
+  if (count % 2 == 1) {
+    return sorted[count / 2];
+  }
+  return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+}  // namespace
+
+SampleSummary SummarizeSamples(std::vector<double> samples){
+
+  SampleSummary summary;
+  summary.count = samples.size();
+  if (samples.empty()) {
+    return summary;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  summary.median = SortedMedian(samples);
+
+  std::vector<double> deviations;
+  for (auto sample : samples) {
+    deviations.push_back(std::fabs(sample - summary.median));
+  }
+  std::sort(deviations.begin(), deviations.end());
+  summary.mad = SortedMedian(deviations);
+
+  // The ranks around the median that the median lies between with 95%
+  // probability, whatever the distribution (binomial normal approximation)
+  auto count = static_cast<double>(samples.size());
+  auto half_width = kConfidenceZ * std::sqrt(count) / 2;
+  auto low_rank = static_cast<long>(std::floor(count / 2 - half_width));
+  auto high_rank = static_cast<long>(std::ceil(count / 2 + half_width));
+  low_rank = std::max(low_rank, 1L);
+  high_rank = std::min(high_rank, static_cast<long>(samples.size()));
+  summary.ci_low = samples[low_rank - 1];
+  summary.ci_high = samples[high_rank - 1];
+
+  return summary;
+}
+
+std::string ComparisonResultToString(const ComparisonResult& result){
+  switch (result) {
+    case COMPARISON_FASTER:
+      return "FASTER";
+    case COMPARISON_SLOWER:
+      return "SLOWER";
+    default:
+      return "UNCHANGED";
+  }
+}
+
+SampleComparison CompareSamples(const std::vector<double>& baseline,
+                                const std::vector<double>& current,
+                                const double threshold){
+
+  SampleComparison comparison;
+  comparison.baseline = SummarizeSamples(baseline);
+  comparison.current = SummarizeSamples(current);
+
+  if (comparison.baseline.median > 0) {
+    comparison.change = comparison.current.median / comparison.baseline.median - 1;
+  }
+
+  if (comparison.change > threshold &&
+      comparison.current.ci_low > comparison.baseline.ci_high) {
+    comparison.result = COMPARISON_SLOWER;
+  }
+  else if (comparison.change < -threshold &&
+      comparison.current.ci_high < comparison.baseline.ci_low) {
+    comparison.result = COMPARISON_FASTER;
+  }
+
+  return comparison;
+}
+
+}  // namespace sqlcheck
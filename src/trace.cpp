@@ -0,0 +1,179 @@
+// TRACE SOURCE
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "include/trace.h"
+#include "include/json.h"
+
+namespace sqlcheck {
+
+bool trace_enabled = false;
+
+namespace {
+
+// Spans recorded per thread, beyond which they are dropped
+const size_t kMaxThreadSpanCount = 1 << 22;
+
+struct TraceEvent {
+  const char* name;
+  const char* category;
+  std::int64_t start;
+  std::int64_t duration;
+};
+
+// Spans of a thread, only touched by the thread while tracing
+struct TraceBuffer {
+
+  TraceBuffer()
+   : thread_id(0),
+     dropped_span_count(0) {
+  }
+
+  std::uint32_t thread_id;
+
+  std::string thread_name;
+
+  std::vector<TraceEvent> events;
+
+  size_t dropped_span_count;
+
+};
+
+std::mutex trace_mutex;
+
+std::vector<std::unique_ptr<TraceBuffer>> trace_buffers;
+
+std::chrono::steady_clock::time_point trace_start;
+
+// Incremented by each trace, so that threads drop buffers of previous traces
+size_t trace_generation = 0;
+
+thread_local TraceBuffer* thread_buffer = nullptr;
+
+thread_local size_t thread_buffer_generation = 0;
+
+TraceBuffer* GetThreadBuffer(){
+  if (thread_buffer != nullptr && thread_buffer_generation == trace_generation) {
+    return thread_buffer;
+  }
+
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+  buffer->thread_id = static_cast<std::uint32_t>(trace_buffers.size() + 1);
+  buffer->events.reserve(1024);
+  thread_buffer = buffer.get();
+  thread_buffer_generation = trace_generation;
+  trace_buffers.push_back(std::move(buffer));
+  return thread_buffer;
+}
+
+void AppendMicroseconds(std::string& output, const std::int64_t nanoseconds){
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%lld.%03lld",
+           static_cast<long long>(nanoseconds / 1000),
+           static_cast<long long>(nanoseconds % 1000));
+  output += buffer;
+}
+
+}  // namespace
+
+void StartTrace(){
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  trace_buffers.clear();
+  trace_generation++;
+  trace_start = std::chrono::steady_clock::now();
+  trace_enabled = true;
+}
+
+std::int64_t GetTraceTime(){
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - trace_start).count();
+}
+
+void RecordTraceSpan(const char* name,
+                     const char* category,
+                     const std::int64_t start,
+                     const std::int64_t end){
+  auto buffer = GetThreadBuffer();
+  if (buffer->events.size() >= kMaxThreadSpanCount) {
+    buffer->dropped_span_count++;
+    return;
+  }
+
+  TraceEvent event;
+  event.name = name;
+  event.category = category;
+  event.start = start;
+  event.duration = end - start;
+  buffer->events.push_back(event);
+}
+
+void SetTraceThreadName(const std::string& name){
+  if (trace_enabled == true) {
+    GetThreadBuffer()->thread_name = name;
+  }
+}
+
+bool WriteTrace(const std::string& file_name){
+  trace_enabled = false;
+
+  std::ofstream output(file_name.c_str(), std::ios::binary);
+  if (output.good() == false) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+
+  for (const auto& buffer : trace_buffers) {
+    std::string thread_id = std::to_string(buffer->thread_id);
+
+    // Thread metadata
+    std::string thread_name = buffer->thread_name.empty() ?
+        "thread " + thread_id : buffer->thread_name;
+    json += first ? "\n" : ",\n";
+    first = false;
+    json += "{\"ph\":\"M\",\"pid\":1,\"tid\":" + thread_id +
+        ",\"name\":\"thread_name\",\"args\":{\"name\":";
+    AppendJsonString(json, thread_name);
+    json += "}}";
+
+    if (buffer->dropped_span_count > 0) {
+      json += ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" + thread_id +
+          ",\"name\":\"dropped_spans\",\"args\":{\"count\":" +
+          std::to_string(buffer->dropped_span_count) + "}}";
+    }
+
+    for (const auto& event : buffer->events) {
+      json += ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" + thread_id + ",\"name\":";
+      AppendJsonString(json, event.name);
+      json += ",\"cat\":";
+      AppendJsonString(json, event.category);
+      json += ",\"ts\":";
+      AppendMicroseconds(json, event.start);
+      json += ",\"dur\":";
+      AppendMicroseconds(json, event.duration);
+      json += "}";
+    }
+
+    // Flush large traces as they are serialized
+    if (json.size() > (1 << 20)) {
+      output << json;
+      json.clear();
+    }
+  }
+
+  json += "\n]}\n";
+  output << json;
+  trace_buffers.clear();
+
+  return output.good();
+}
+
+}  // namespace sqlcheck
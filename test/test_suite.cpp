@@ -1,13 +1,111 @@
 // TEST SUITE
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <regex>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cache.h"
 #include "checker.h"
+#include "changes.h"
+#include "counters.h"
+#include "interner.h"
+#include "json.h"
+#include "lexer.h"
+#include "list.h"
+#include "literals.h"
+#include "lsp.h"
+#include "matcher.h"
+#include "perf_counters.h"
+#include "reader.h"
+#include "scheduler.h"
+#include "splitter.h"
+#include "stats.h"
+#include "trace.h"
 
 #include <gtest/gtest.h>
 
 namespace sqlcheck {
 
+namespace {
+
+// Directory of test files, removed with everything in it when the test
+// ends, even if an assertion fails
+class TempDirectory {
+
+ public:
+  TempDirectory() {
+    char path_template[] = "/tmp/sqlcheck_test_XXXXXX";
+    if (mkdtemp(path_template) == nullptr) {
+      throw std::runtime_error(std::string("mkdtemp: ") + strerror(errno));
+    }
+    path_ = path_template;
+  }
+
+  ~TempDirectory() {
+    Remove(path_);
+  }
+
+  const std::string& GetPath() const {
+    return path_;
+  }
+
+  // Write a file in the directory, returns its path
+  std::string Write(const std::string& name, const std::string& text) const {
+    auto path = path_ + "/" + name;
+    std::ofstream(path) << text;
+    return path;
+  }
+
+  TempDirectory(const TempDirectory&) = delete;
+  TempDirectory& operator=(const TempDirectory&) = delete;
+
+ private:
+
+  // Links are removed, not followed
+  static void Remove(const std::string& path) {
+    struct stat path_stat;
+    if (lstat(path.c_str(), &path_stat) != 0) {
+      return;
+    }
+    if (S_ISDIR(path_stat.st_mode) == false) {
+      unlink(path.c_str());
+      return;
+    }
+
+    std::vector<std::string> entries;
+    if (DIR* stream = opendir(path.c_str())) {
+      while (auto entry = readdir(stream)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+          entries.push_back(path + "/" + name);
+        }
+      }
+      closedir(stream);
+    }
+    for (const auto& entry : entries) {
+      Remove(entry);
+    }
+    rmdir(path.c_str());
+  }
+
+  std::string path_;
+
+};
+
+}  // namespace
+
 TEST(TestSuite, SelectStarTest) {
 
   Configuration default_conf;
@@ -527,4 +625,1365 @@ TEST(TestSuite, SingleColumnTable) {
   Check(default_conf);
 }
 
+TEST(TestSuite, ChangedLinesTest) {
+
+  LineRanges ranges;
+  std::istringstream diff(
+      "diff --git a/db/schema.sql b/db/schema.sql\n"
+      "--- a/db/schema.sql\n"
+      "+++ b/db/schema.sql\n"
+      "@@ -2,3 +2,4 @@\n"
+      " SELECT 1;\n"
+      "-SELECT 2;\n"
+      "+SELECT * FROM foo;\n"
+      "+-- added comment\n"
+      " SELECT 3;\n"
+      "--- a/other.sql\n"
+      "+++ b/other.sql\n"
+      "@@ -1 +1 @@\n"
+      "-SELECT 1;\n"
+      "+SELECT 2;\n"
+  );
+  ParseUnifiedDiff(diff, "db/schema.sql", ranges);
+  ASSERT_EQ(ranges.size(), 1);
+  EXPECT_EQ(ranges[0].first, 2);
+  EXPECT_EQ(ranges[0].second, 4);
+
+  ranges.clear();
+  EXPECT_TRUE(ParseChangedLines("other.sql:1 schema.sql:7-9,3", "schema.sql", ranges));
+  EXPECT_EQ(LineRangesToString(ranges), "3,7-9");
+  EXPECT_TRUE(OverlapsLineRanges(ranges, 5, 7));
+  EXPECT_FALSE(OverlapsLineRanges(ranges, 4, 6));
+  EXPECT_FALSE(ParseChangedLines("9-7", "schema.sql", ranges));
+
+  Configuration default_conf;
+  default_conf.testing_mode = true;
+  default_conf.verbose = false;
+  default_conf.changed_lines_mode = true;
+  default_conf.changed_lines.push_back(std::make_pair(3, 3));
+
+  std::unique_ptr<std::istringstream> stream(new std::istringstream());
+  stream->str(
+      "SELECT * FROM foo;\n"
+      "SELECT a FROM bar\n"
+      "ORDER BY RAND();\n"
+      "SELECT * FROM baz;\n"
+  );
+
+  default_conf.test_stream.reset(stream.release());
+
+  EXPECT_TRUE(Check(default_conf));
+  EXPECT_EQ(default_conf.checker_stats.total.risk_levels[RISK_LEVEL_ALL], 1);
+
+  // Each of several files is checked at its own changed lines
+  TempDirectory directory;
+  auto a_file = directory.Write("a.sql", "SELECT * FROM a;\nSELECT 1;\nSELECT * FROM b;\n");
+  auto b_file = directory.Write("b.sql", "SELECT * FROM c;\nSELECT * FROM d;\n");
+
+  Configuration files_conf;
+  files_conf.color_mode = false;
+  files_conf.line_width = 0;
+  files_conf.changed_lines_mode = true;
+  files_conf.file_names = {a_file, b_file};
+  files_conf.file_changed_lines.resize(2);
+  for (size_t file = 0; file < 2; file++) {
+    EXPECT_TRUE(ParseChangedLines("a.sql:1 b.sql:2", files_conf.file_names[file],
+                                  files_conf.file_changed_lines[file]));
+  }
+  EXPECT_EQ(LineRangesToString(files_conf.file_changed_lines[0]), "1");
+  EXPECT_EQ(LineRangesToString(files_conf.file_changed_lines[1]), "2");
+
+  testing::internal::CaptureStdout();
+  Check(files_conf);
+  auto output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(output.find("SELECT * FROM a;"), std::string::npos);
+  EXPECT_EQ(output.find("SELECT * FROM b;"), std::string::npos);
+  EXPECT_EQ(output.find("SELECT * FROM c;"), std::string::npos);
+  EXPECT_NE(output.find("SELECT * FROM d;"), std::string::npos);
+
+}
+
+TEST(TestSuite, LspIncrementalTest) {
+
+  Configuration default_conf;
+  std::ostringstream output;
+  LspServer server(default_conf, output);
+
+  std::string uri = "file:///schema.sql";
+  server.HandleMessage(
+      "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}");
+  server.HandleMessage(
+      "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":"
+      "{\"textDocument\":{\"uri\":\"" + uri + "\",\"languageId\":\"sql\",\"version\":1,"
+      "\"text\":\"SELECT a FROM foo;\\nSELECT b FROM bar;\\nSELECT c\\nFROM baz;\\n\"}}}");
+
+  auto document = server.GetDocument(uri);
+  ASSERT_TRUE(document != nullptr);
+  EXPECT_EQ(document->statements.size(), 4);
+  auto checked_statements = server.GetCheckedStatementCount();
+
+  // Turn the second statement into a SELECT *
+  server.HandleMessage(
+      "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":"
+      "{\"textDocument\":{\"uri\":\"" + uri + "\",\"version\":2},"
+      "\"contentChanges\":[{\"range\":{\"start\":{\"line\":1,\"character\":7},"
+      "\"end\":{\"line\":1,\"character\":8}},\"text\":\"*\"}]}}");
+
+  EXPECT_EQ(server.GetCheckedStatementCount(), checked_statements + 1);
+  EXPECT_EQ(document->text, "SELECT a FROM foo;\nSELECT * FROM bar;\nSELECT c\nFROM baz;\n");
+  ASSERT_EQ(document->statements.size(), 4);
+  EXPECT_EQ(document->statements[2].line, 1);
+  EXPECT_EQ(document->statements[3].line, 3);
+  ASSERT_EQ(document->statements[1].findings.size(), 1);
+  EXPECT_EQ(document->statements[1].findings[0].title, "SELECT *");
+
+  // Merge the last two statements by removing the delimiter
+  server.HandleMessage(
+      "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":"
+      "{\"textDocument\":{\"uri\":\"" + uri + "\",\"version\":3},"
+      "\"contentChanges\":[{\"range\":{\"start\":{\"line\":1,\"character\":17},"
+      "\"end\":{\"line\":1,\"character\":18}},\"text\":\"\"}]}}");
+
+  EXPECT_EQ(document->statements.size(), 3);
+  EXPECT_NE(output.str().find("\"range\":{\"start\":{\"line\":1,\"character\":0}"),
+            std::string::npos);
+
+  // Positions out of range are clamped to the document
+  server.HandleMessage(
+      "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":"
+      "{\"textDocument\":{\"uri\":\"" + uri + "\",\"version\":4},"
+      "\"contentChanges\":[{\"range\":{\"start\":{\"line\":-1,\"character\":-5},"
+      "\"end\":{\"line\":0,\"character\":1e300}},\"text\":\"SELECT d FROM foo;\"}]}}");
+
+  EXPECT_EQ(document->text, "SELECT d FROM foo;\nSELECT * FROM bar\nSELECT c\nFROM baz;\n");
+  EXPECT_EQ(document->statements.size(), 3);
+
+  // Table names of earlier edits are not kept
+  for (int i = 0; i < 100; i++) {
+    server.HandleMessage(
+        "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":"
+        "{\"textDocument\":{\"uri\":\"" + uri + "\",\"version\":" + std::to_string(i + 5) + "},"
+        "\"contentChanges\":[{\"range\":{\"start\":{\"line\":0,\"character\":0},"
+        "\"end\":{\"line\":0,\"character\":1000}},\"text\":\"CREATE TABLE t" +
+        std::to_string(i) + " (a INT);\"}]}}");
+  }
+  EXPECT_LE(GetInterner().GetCount(), 1u);
+
+  server.HandleMessage("{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"shutdown\"}");
+  EXPECT_TRUE(server.IsShutdown());
+  EXPECT_FALSE(server.HandleMessage("{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}"));
+
+  // Surrogate pairs of messages, a high surrogate needing a low one
+  JsonValue value;
+  ASSERT_TRUE(ParseJson("\"\\uD83D\\uDE00\"", value));
+  EXPECT_EQ(value.string, "\xF0\x9F\x98\x80");
+  EXPECT_FALSE(ParseJson("\"\\uD800\\u0041\"", value));
+
+}
+
+TEST(TestSuite, PipelineOrderTest) {
+
+  // Statements spanning several chunks of input
+  std::ostringstream sql;
+  for (int i = 0; i < 3000; i++) {
+    sql << "SELECT * FROM t" << i << " WHERE a IS NULL\n  OR b = " << i << ";\n";
+    if (i % 7 == 0) {
+      sql << "CREATE TABLE c" << i << " (id INT, cost FLOAT);\n\n";
+    }
+  }
+
+  std::string outputs[2];
+  FindingCounts stats[2];
+  size_t thread_counts[2] = {1, 4};
+
+  for (int i = 0; i < 2; i++) {
+    Configuration default_conf;
+    default_conf.testing_mode = true;
+    default_conf.color_mode = false;
+    default_conf.thread_count = thread_counts[i];
+    default_conf.test_stream.reset(new std::istringstream(sql.str()));
+
+    testing::internal::CaptureStdout();
+    Check(default_conf);
+    outputs[i] = testing::internal::GetCapturedStdout();
+    stats[i] = default_conf.checker_stats.total;
+  }
+
+  EXPECT_EQ(outputs[0], outputs[1]);
+  EXPECT_EQ(memcmp(&stats[0], &stats[1], sizeof(FindingCounts)), 0);
+  EXPECT_NE(outputs[0].find("SQL Statement at line 6857: SELECT * FROM t2999"), std::string::npos);
+
+}
+
+TEST(TestSuite, WorkStealingTest) {
+
+  // Tasks spawning tasks all run before the scheduler finishes
+  std::atomic<size_t> task_count(0);
+  {
+    TaskScheduler scheduler(3);
+    for (int i = 0; i < 50; i++) {
+      scheduler.Submit([&](size_t worker) {
+        for (int j = 0; j < 10; j++) {
+          scheduler.Spawn(worker, [&](size_t) { task_count++; });
+        }
+        task_count++;
+      });
+    }
+    scheduler.Finish();
+  }
+  EXPECT_EQ(task_count.load(), 550u);
+
+  // Submitted tasks start in order, after the tasks spawned before them
+  // (newest first)
+  std::vector<int> order;
+  {
+    TaskScheduler scheduler(1);
+    for (int i = 0; i < 5; i++) {
+      scheduler.Submit([&order, &scheduler, i](size_t worker) {
+        order.push_back(i);
+        if (i == 0) {
+          scheduler.Spawn(worker, [&order](size_t) { order.push_back(10); });
+          scheduler.Spawn(worker, [&order](size_t) { order.push_back(11); });
+        }
+      });
+    }
+    scheduler.Finish();
+  }
+  EXPECT_EQ(order, std::vector<int>({0, 11, 10, 1, 2, 3, 4}));
+
+  // Large statements checked one task per check, between small ones
+  std::ostringstream sql;
+  for (int i = 0; i < 200; i++) {
+    if (i % 40 == 3) {
+      sql << "SELECT * FROM a0\n";
+      for (int j = 0; j < 300; j++) {
+        sql << " JOIN t" << j << " ON t" << j << ".id = a0.id OR t" << j << ".x LIKE '%v'\n";
+      }
+      sql << ";\n";
+    }
+    else {
+      sql << "SELECT * FROM t" << i << " WHERE a IS NULL;\n";
+    }
+  }
+
+  std::string outputs[2];
+  size_t thread_counts[2] = {1, 3};
+
+  for (int i = 0; i < 2; i++) {
+    Configuration default_conf;
+    default_conf.testing_mode = true;
+    default_conf.color_mode = false;
+    default_conf.thread_count = thread_counts[i];
+    default_conf.test_stream.reset(new std::istringstream(sql.str()));
+
+    testing::internal::CaptureStdout();
+    Check(default_conf);
+    outputs[i] = testing::internal::GetCapturedStdout();
+  }
+
+  EXPECT_EQ(outputs[0], outputs[1]);
+  EXPECT_NE(outputs[0].find("SQL Statement at line 4: SELECT * FROM a0"), std::string::npos);
+  EXPECT_NE(outputs[0].find("Spaghetti Query Alert"), std::string::npos);
+
+}
+
+TEST(TestSuite, SingleThreadTest) {
+
+  // Without workers, tasks run on the calling thread
+  size_t task_count = 0;
+  {
+    TaskScheduler scheduler(0);
+    scheduler.Submit([&](size_t worker) {
+      scheduler.Spawn(worker, [&](size_t) { task_count++; });
+      EXPECT_EQ(task_count, 1u);
+      task_count++;
+    });
+    EXPECT_EQ(task_count, 2u);
+  }
+
+  // Small inputs are checked without threads, as the threads would
+  std::ostringstream sql;
+  for (int i = 0; i < 50; i++) {
+    if (i % 20 == 3) {
+      sql << "SELECT * FROM a0\n";
+      for (int j = 0; j < 300; j++) {
+        sql << " JOIN t" << j << " ON t" << j << ".id = a0.id\n";
+      }
+      sql << ";\n";
+    }
+    else {
+      sql << "SELECT * FROM t" << i << " WHERE a IS NULL;\n";
+    }
+  }
+
+  // The trailing comment makes the input large enough for the threads
+  std::string inputs[2] = {sql.str(), sql.str() + "-- " + std::string(100000, 'x')};
+  std::string outputs[2];
+
+  for (int i = 0; i < 2; i++) {
+    Configuration default_conf;
+    default_conf.testing_mode = true;
+    default_conf.color_mode = false;
+    default_conf.thread_count = 2;
+    default_conf.test_stream.reset(new std::istringstream(inputs[i]));
+
+    testing::internal::CaptureStdout();
+    Check(default_conf);
+    outputs[i] = testing::internal::GetCapturedStdout();
+  }
+
+  auto findings = outputs[0].substr(0, outputs[0].find("\n==================== Summary"));
+  EXPECT_NE(findings.find("SELECT * FROM a0"), std::string::npos);
+  EXPECT_EQ(outputs[1].compare(0, findings.size(), findings), 0);
+
+}
+
+TEST(TestSuite, ParallelSplitTest) {
+
+  // Delimiters in strings, identifiers and comments do not end statements
+  SplitMachine machine(';', false);
+  SplitMachine mysql_machine(';', true);
+  std::string sql =
+      "SELECT ';', \"a;b\", `c;d` FROM t; -- e;f\n"
+      "SELECT 'it''s;', 'x\\';' /* g;\n h; */ FROM u;";
+  std::vector<SplitDelimiter> delimiters;
+  std::uint32_t line_count;
+  auto state = mysql_machine.Scan(sql.data(), sql.size(), SPLIT_STATE_NORMAL,
+                                  delimiters, line_count);
+  ASSERT_EQ(delimiters.size(), 2u);
+  EXPECT_EQ(delimiters[0].offset, sql.find("; --"));
+  EXPECT_EQ(delimiters[1].line, 2u);
+  EXPECT_EQ(line_count, 2u);
+  EXPECT_EQ(state, SPLIT_STATE_NORMAL);
+
+  // Backslashes are plain characters in standard strings
+  std::string paths =
+      "INSERT INTO paths VALUES ('C:\\');\n"
+      "SELECT a FROM t;\n"
+      "SELECT b FROM u;\n"
+      "SELECT c FROM v;\n";
+  delimiters.clear();
+  state = machine.Scan(paths.data(), paths.size(), SPLIT_STATE_NORMAL,
+                       delimiters, line_count);
+  ASSERT_EQ(delimiters.size(), 4u);
+  EXPECT_EQ(delimiters[0].offset, paths.find(");") + 1);
+  EXPECT_EQ(delimiters[3].line, 3u);
+  EXPECT_EQ(state, SPLIT_STATE_NORMAL);
+
+  delimiters.clear();
+  state = mysql_machine.Scan(paths.data(), paths.size(), SPLIT_STATE_NORMAL,
+                             delimiters, line_count);
+  EXPECT_EQ(delimiters.size(), 0u);
+  EXPECT_EQ(state, SPLIT_STATE_SINGLE_QUOTE);
+
+  // Chunks scanned in parallel find the same delimiters as a single scan
+  const char* pieces[] = {
+    "SELECT a FROM t WHERE b = 'x;y';\n", "-- note; with ' quote\n",
+    "/* block ; ' \" */", "INSERT INTO t VALUES ('a\\'b;', \"c;\");\n",
+    "'", "\"", "`", ";", "\n", "*", "/", "-", "\\"
+  };
+  std::string input;
+  unsigned int seed = 7;
+  while (input.size() < (5 << 20)) {
+    seed = seed * 1103515245 + 12345;
+    input += pieces[(seed >> 16) % (sizeof(pieces) / sizeof(pieces[0]))];
+  }
+
+  for (const auto* split_machine : {&machine, &mysql_machine}) {
+    for (int start_state = 0; start_state < SPLIT_STATE_COUNT; start_state++) {
+      std::vector<SplitDelimiter> serial_delimiters;
+      std::vector<SplitDelimiter> parallel_delimiters;
+      std::uint32_t serial_line_count;
+      std::uint32_t parallel_line_count;
+
+      auto serial_state = split_machine->Scan(input.data(), input.size(),
+                                              static_cast<SplitState>(start_state),
+                                              serial_delimiters, serial_line_count);
+      auto parallel_state = FindDelimiters(*split_machine, input.data(), input.size(),
+                                           static_cast<SplitState>(start_state), 4,
+                                           parallel_delimiters, parallel_line_count);
+
+      EXPECT_EQ(serial_state, parallel_state);
+      EXPECT_EQ(serial_line_count, parallel_line_count);
+      ASSERT_EQ(serial_delimiters.size(), parallel_delimiters.size());
+      for (size_t i = 0; i < serial_delimiters.size(); i++) {
+        ASSERT_EQ(serial_delimiters[i].offset, parallel_delimiters[i].offset);
+        ASSERT_EQ(serial_delimiters[i].line, parallel_delimiters[i].line);
+      }
+    }
+  }
+
+}
+
+TEST(TestSuite, FileReaderTest) {
+
+  TempDirectory temp_directory;
+  auto directory = temp_directory.GetPath();
+  mkdir((directory + "/nested").c_str(), 0700);
+
+  // Files of various sizes, with a nested directory and a file to skip
+  std::vector<std::string> contents;
+  for (int i = 0; i < 40; i++) {
+    std::string text;
+    for (int j = 0; j < i * i * (i % 3 == 0 ? 50 : 1); j++) {
+      text += "SELECT * FROM t" + std::to_string(i) + ";\n";
+    }
+    contents.push_back(text);
+
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "%s/f%02d.sql", (i % 4 == 0) ? "nested" : ".", i);
+    temp_directory.Write(file_name, text);
+  }
+  temp_directory.Write("notes.txt", "SELECT 1;");
+
+  // Links to files are followed, links to directories are not
+  ASSERT_EQ(symlink("..", (directory + "/nested/loop").c_str()), 0);
+  ASSERT_EQ(symlink("../f01.sql", (directory + "/nested/linked_f01.sql").c_str()), 0);
+
+  std::vector<std::string> file_names;
+  ASSERT_TRUE(CollectInputFiles(directory, file_names));
+  ASSERT_EQ(file_names.size(), 41u);
+  EXPECT_EQ(file_names[0], directory + "/f01.sql");
+  EXPECT_EQ(file_names[30], directory + "/nested/f00.sql");
+  EXPECT_EQ(file_names[40], directory + "/nested/linked_f01.sql");
+  EXPECT_FALSE(CollectInputFiles(directory + "/missing", file_names));
+
+  file_names.push_back(directory + "/missing.sql");
+
+  for (int use_io_uring = 0; use_io_uring < 2; use_io_uring++) {
+    auto reader = OpenFileReader(file_names, 8, use_io_uring == 1);
+    FileData file;
+    size_t index = 0;
+    while (reader->Next(file)) {
+      ASSERT_EQ(file.index, index);
+      if (index == 41) {
+        EXPECT_EQ(file.error, ENOENT);
+      }
+      else {
+        auto number = std::stoi(file_names[index].substr(file_names[index].size() - 6, 2));
+        EXPECT_EQ(file.error, 0);
+        EXPECT_EQ(file.data, contents[number]);
+      }
+      index++;
+    }
+    EXPECT_EQ(index, 42u);
+  }
+
+}
+
+TEST(TestSuite, WrapTextTest) {
+
+  // Bullets start paragraphs and headings end their line
+  EXPECT_EQ(WrapText("● Heading:  first words of a paragraph that goes on for long enough "
+                     "to wrap at eighty columns. ● Second:  next"),
+            "● Heading:\n"
+            "first words of a paragraph that goes on for long enough to wrap at eighty\n"
+            "columns.\n"
+            "\n"
+            "● Second:\n"
+            "next");
+  EXPECT_EQ(WrapText(" \t\n"), "");
+  EXPECT_EQ(WrapText(std::string(90, 'x') + " y"), std::string(90, 'x') + "\ny");
+
+  // Words longer than the line are on their own line, and the words after
+  // them are wrapped again
+  EXPECT_EQ(WrapText("SELECT * FROM averyveryverylongtablename_abcdef WHERE a = 1 AND b = 2", 20),
+            "SELECT * FROM\n"
+            "averyveryverylongtablename_abcdef\n"
+            "WHERE a = 1 AND b =\n"
+            "2");
+  EXPECT_EQ(WrapText(std::string(25, 'x') + " a b", 20), std::string(25, 'x') + "\na b");
+
+  // Verbose messages are wrapped the same for every finding
+  Configuration default_conf;
+  default_conf.testing_mode = true;
+  default_conf.verbose = true;
+  default_conf.color_mode = false;
+  default_conf.test_stream.reset(new std::istringstream("SELECT * FROM a;\nSELECT * FROM b;"));
+
+  testing::internal::CaptureStdout();
+  Check(default_conf);
+  auto output = testing::internal::GetCapturedStdout();
+
+  auto message = WrapText("● Inefficiency in moving data to the consumer:  When you SELECT *,");
+  auto first = output.find(message);
+  ASSERT_NE(first, std::string::npos);
+  EXPECT_NE(output.find(message, first + 1), std::string::npos);
+
+}
+
+TEST(TestSuite, OutputWidthTest) {
+
+  std::ostringstream narrow;
+  WriteWrappedText(narrow, "SELECT first_column, second_column FROM some_table WHERE x = 1", 40);
+  EXPECT_EQ(narrow.str(),
+            "SELECT first_column, second_column FROM\n"
+            "some_table WHERE x = 1");
+
+  // Without wrapping the text is written as it is
+  std::ostringstream verbatim;
+  WriteWrappedText(verbatim, "SELECT *\n  FROM a", 0);
+  EXPECT_EQ(verbatim.str(), "SELECT *\n  FROM a");
+
+  Configuration default_conf;
+  default_conf.testing_mode = true;
+  default_conf.verbose = true;
+  default_conf.color_mode = false;
+  default_conf.line_width = 0;
+  default_conf.test_stream.reset(new std::istringstream(
+      "SELECT * FROM a WHERE " + std::string(100, 'x') + " = 1;"));
+
+  testing::internal::CaptureStdout();
+  Check(default_conf);
+  auto output = testing::internal::GetCapturedStdout();
+
+  // Statements stay on one line, messages keep their paragraphs
+  EXPECT_NE(output.find("SELECT * FROM a WHERE " + std::string(100, 'x') + " = 1;"),
+            std::string::npos);
+  EXPECT_NE(output.find("● Inefficiency in moving data to the consumer:\n"), std::string::npos);
+
+}
+
+TEST(TestSuite, DedupTest) {
+
+  // Statements are the same once normalized, whatever their case and spaces,
+  // and are printed as they first occur
+  std::ostringstream sql;
+  for (int i = 0; i < 3; i++) {
+    sql << "SELECT * FROM a;\nselect  *  from b;\nSELECT   * FROM A;\n";
+  }
+
+  // The trailing comment makes the input large enough for the threads
+  std::string inputs[2] = {sql.str(), sql.str() + "-- " + std::string(100000, 'x')};
+
+  for (int i = 0; i < 2; i++) {
+    Configuration default_conf;
+    default_conf.testing_mode = true;
+    default_conf.color_mode = false;
+    default_conf.dedup_mode = true;
+    default_conf.thread_count = 2;
+    default_conf.test_stream.reset(new std::istringstream(inputs[i]));
+
+    testing::internal::CaptureStdout();
+    Check(default_conf);
+    auto output = testing::internal::GetCapturedStdout();
+
+    auto first = output.find("SQL Statement at lines 1, 3, 4, 6, 7, 9 (6 occurrences): "
+                             "SELECT * FROM a;\n");
+    auto second = output.find("SQL Statement at lines 2, 5, 8 (3 occurrences): "
+                              "select * from b;\n");
+    EXPECT_NE(first, std::string::npos);
+    EXPECT_NE(second, std::string::npos);
+    EXPECT_LT(first, second);
+
+    // Every occurrence counts towards the summary (the trailing comment
+    // has findings of its own)
+    if (i == 0) {
+      EXPECT_EQ(output.find("SQL Statement at line "), std::string::npos);
+      EXPECT_EQ(default_conf.checker_stats.total.risk_levels[RISK_LEVEL_ALL] % 9, 0);
+      EXPECT_GT(default_conf.checker_stats.total.risk_levels[RISK_LEVEL_ALL], 0);
+    }
+  }
+
+}
+
+TEST(TestSuite, SummaryTest) {
+
+  TempDirectory temp_directory;
+  auto directory = temp_directory.GetPath();
+  temp_directory.Write("a.sql", "SELECT * FROM a;\nSELECT * FROM b ORDER BY RAND();\n");
+  temp_directory.Write("b.sql", "SELECT id FROM c;\n");
+  temp_directory.Write("c.sql", "SELECT * FROM d;\n");
+
+  size_t select_star = 0;
+  size_t order_by_rand = 0;
+  for (size_t rule = 0; rule < GetRules().size(); rule++) {
+    if (std::string(GetRules()[rule].name) == "SelectStar") {
+      select_star = rule;
+    }
+    if (std::string(GetRules()[rule].name) == "OrderByRand") {
+      order_by_rand = rule;
+    }
+  }
+  ASSERT_EQ(GetRules().size(), kRuleCount);
+
+  // The counts of the threads add up to the same summary
+  for (size_t thread_count = 1; thread_count <= 3; thread_count += 2) {
+    Configuration default_conf;
+    default_conf.color_mode = false;
+    default_conf.thread_count = thread_count;
+    default_conf.file_names = {directory + "/a.sql", directory + "/b.sql", directory + "/c.sql"};
+
+    testing::internal::CaptureStdout();
+    Check(default_conf);
+    auto output = testing::internal::GetCapturedStdout();
+
+    const auto& stats = default_conf.checker_stats;
+    EXPECT_EQ(stats.total.rules[select_star], 3u);
+    EXPECT_EQ(stats.total.rules[order_by_rand], 1u);
+    EXPECT_EQ(stats.total.pattern_types[PATTERN_TYPE_QUERY], 4u);
+    ASSERT_EQ(stats.files.size(), 3u);
+    EXPECT_EQ(stats.files[0].rules[select_star], 2u);
+    EXPECT_EQ(stats.files[1].risk_levels[RISK_LEVEL_ALL], 0u);
+    EXPECT_EQ(stats.files[2].risk_levels[RISK_LEVEL_ALL], 1u);
+
+    std::uint64_t file_total = 0;
+    for (const auto& file : stats.files) {
+      file_total += file.risk_levels[RISK_LEVEL_ALL];
+    }
+    EXPECT_EQ(file_total, stats.total.risk_levels[RISK_LEVEL_ALL]);
+
+    EXPECT_NE(output.find("By Rule\n>  SelectStar"), std::string::npos);
+    EXPECT_NE(output.find(">  " + directory + "/c.sql :: 1 (1 high"), std::string::npos);
+    EXPECT_EQ(output.find(directory + "/b.sql ::"), std::string::npos);
+  }
+
+}
+
+TEST(TestSuite, CountersTest) {
+
+  // Snapshots taken while the threads count never go back
+  ResetCounters();
+  Finding finding;
+  finding.rule = 2;
+  finding.risk_level = RISK_LEVEL_HIGH;
+  finding.pattern_type = PATTERN_TYPE_QUERY;
+
+  std::atomic<bool> counting(true);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; i++) {
+    threads.emplace_back([&finding]() {
+      for (int j = 0; j < 10000; j++) {
+        CountStatement("SELECT 1");
+        CountFinding(finding);
+      }
+    });
+  }
+  std::thread reader([&counting]() {
+    std::uint64_t statements = 0;
+    while (counting.load()) {
+      auto snapshot = ReadCounters();
+      EXPECT_GE(snapshot.statements, statements);
+      statements = snapshot.statements;
+    }
+  });
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  counting.store(false);
+  reader.join();
+
+  auto snapshot = ReadCounters();
+  EXPECT_EQ(snapshot.statements, 30000u);
+  EXPECT_EQ(snapshot.bytes, 8 * 30000u);
+  EXPECT_EQ(snapshot.findings.risk_levels[RISK_LEVEL_ALL], 30000u);
+  EXPECT_EQ(snapshot.findings.risk_levels[RISK_LEVEL_HIGH], 30000u);
+  EXPECT_EQ(snapshot.findings.pattern_types[PATTERN_TYPE_QUERY], 30000u);
+  EXPECT_EQ(snapshot.findings.rules[2], 30000u);
+
+  // Blank statements are not counted, and each run starts from zero
+  Configuration default_conf;
+  default_conf.testing_mode = true;
+  default_conf.thread_count = 2;
+  default_conf.test_stream.reset(new std::istringstream("SELECT * FROM a;\nSELECT 1;\n"));
+
+  testing::internal::CaptureStdout();
+  Check(default_conf);
+  testing::internal::GetCapturedStdout();
+
+  EXPECT_EQ(default_conf.checker_stats.statements, 2u);
+  EXPECT_EQ(ReadCounters().statements, 2u);
+
+}
+
+TEST(TestSuite, FindingCacheTest) {
+
+  FindingCache cache(1 << 20);
+  std::vector<Finding> findings(1);
+  findings[0].title = "title";
+
+  auto fingerprint = GetStatementFingerprint("select * from a;", LineShifts());
+  EXPECT_FALSE(GetStatementFingerprint("select * from b;", LineShifts()) == fingerprint);
+  EXPECT_TRUE(GetStatementFingerprint("select * from a;", LineShifts()) == fingerprint);
+
+  std::vector<Finding> cached_findings;
+  EXPECT_FALSE(cache.Find(fingerprint, cached_findings));
+  cache.Insert(fingerprint, findings);
+  ASSERT_TRUE(cache.Find(fingerprint, cached_findings));
+  ASSERT_EQ(cached_findings.size(), 1u);
+  EXPECT_EQ(cached_findings[0].title, "title");
+
+  // Entries of a shard beyond its capacity are evicted, except those found
+  // since the clock hand last passed them
+  ResetCounters();
+  FindingCache small_cache(64 * 4096);
+  StatementFingerprint kept = {0, 0, 0};
+  small_cache.Insert(kept, findings);
+  for (std::uint64_t i = 1; i <= 1000; i++) {
+    EXPECT_TRUE(small_cache.Find(kept, cached_findings));
+    StatementFingerprint other = {0, i, 0};
+    small_cache.Insert(other, findings);
+  }
+  EXPECT_LE(small_cache.GetSize(), 4096u);
+  EXPECT_TRUE(small_cache.Find(kept, cached_findings));
+  StatementFingerprint first_other = {0, 1, 0};
+  EXPECT_FALSE(small_cache.Find(first_other, cached_findings));
+
+  auto counters = ReadCounters();
+  EXPECT_EQ(counters.cache_hits, 1001u);
+  EXPECT_EQ(counters.cache_misses, 1u);
+  EXPECT_GT(counters.cache_evictions, 900u);
+
+  // Without capacity, nothing is remembered
+  FindingCache no_cache(0);
+  no_cache.Insert(kept, findings);
+  EXPECT_FALSE(no_cache.Find(kept, cached_findings));
+  EXPECT_EQ(no_cache.GetSize(), 0u);
+
+  // Statements repeated across files, small and large, are reported in
+  // each file at their own lines
+  TempDirectory temp_directory;
+  auto directory = temp_directory.GetPath();
+  std::string large_statement = "SELECT * FROM a WHERE b IN (" + std::string(10000, '1') + ");\n";
+  temp_directory.Write("a.sql", "SELECT * FROM t;\n" + large_statement);
+  temp_directory.Write("b.sql", "SELECT 1;\nSELECT 2;\n" + large_statement + "SELECT * FROM t;\n");
+
+  Configuration default_conf;
+  default_conf.color_mode = false;
+  default_conf.thread_count = 1;
+  default_conf.line_width = 0;
+  default_conf.file_names = {directory + "/a.sql", directory + "/b.sql"};
+
+  testing::internal::CaptureStdout();
+  Check(default_conf);
+  auto output = testing::internal::GetCapturedStdout();
+
+  EXPECT_NE(output.find("SQL Statement at line 1: SELECT * FROM t;"), std::string::npos);
+  EXPECT_NE(output.find("SQL Statement at line 2: SELECT * FROM a WHERE"), std::string::npos);
+  EXPECT_NE(output.find("SQL Statement at line 3: SELECT * FROM a WHERE"), std::string::npos);
+  EXPECT_NE(output.find("SQL Statement at line 4: SELECT * FROM t;"), std::string::npos);
+  EXPECT_NE(output.find("[" + directory + "/b.sql]: (HIGH RISK) (QUERY ANTI-PATTERN) SELECT *"),
+            std::string::npos);
+  EXPECT_EQ(default_conf.checker_stats.files[0].risk_levels[RISK_LEVEL_ALL],
+            default_conf.checker_stats.files[1].risk_levels[RISK_LEVEL_ALL]);
+  // The single worker finishes the checks of the large statement of a.sql,
+  // which it spawned, before taking the statements of b.sql: the small and
+  // large statements and the empty last statement of b.sql are found
+  EXPECT_EQ(default_conf.checker_stats.cache_hits, 3u);
+
+}
+
+TEST(TestSuite, TraceTest) {
+
+  char file_template[] = "/tmp/sqlcheck_trace_XXXXXX";
+  close(mkstemp(file_template));
+
+  Configuration default_conf;
+  default_conf.testing_mode = true;
+  default_conf.thread_count = 2;
+  default_conf.trace_file = file_template;
+  // Inputs this large are checked by the worker threads
+  default_conf.test_stream.reset(new std::istringstream(
+      "SELECT * FROM a;\nSELECT * FROM b WHERE c = 1;\n-- " + std::string(100000, 'x')));
+
+  testing::internal::CaptureStdout();
+  Check(default_conf);
+  testing::internal::GetCapturedStdout();
+  EXPECT_FALSE(trace_enabled);
+
+  std::ifstream trace_stream(file_template);
+  std::string text((std::istreambuf_iterator<char>(trace_stream)),
+                   std::istreambuf_iterator<char>());
+  unlink(file_template);
+
+  JsonValue trace;
+  ASSERT_TRUE(ParseJson(text, trace));
+  const auto& events = trace.Get("traceEvents");
+  ASSERT_EQ(events.type, JSON_TYPE_ARRAY);
+
+  // Spans of every stage, and a span per statement of every rule whose
+  // keywords the statement has
+  std::map<std::string, int> span_counts;
+  std::set<std::string> thread_names;
+  for (const auto& event : events.array) {
+    if (event.Get("ph").string == "X") {
+      EXPECT_GE(event.Get("dur").number, 0);
+      span_counts[event.Get("cat").string + ":" + event.Get("name").string]++;
+    }
+    else if (event.Get("name").string == "thread_name") {
+      thread_names.insert(event.Get("args").Get("name").string);
+    }
+  }
+  EXPECT_EQ(span_counts["stage:read"] > 0, true);
+  EXPECT_EQ(span_counts["stage:split"] > 0, true);
+  EXPECT_EQ(span_counts["stage:normalize"], 3);
+  EXPECT_EQ(span_counts["stage:write"] > 0, true);
+  EXPECT_EQ(span_counts["rule:SelectStar"], 3);
+  EXPECT_EQ(span_counts["rule:MultiValuedAttribute"], 3);
+  EXPECT_EQ(thread_names.count("splitter"), 1u);
+  EXPECT_EQ(thread_names.count("writer"), 1u);
+  EXPECT_EQ(thread_names.count("worker 0"), 1u);
+
+}
+
+TEST(TestSuite, PerfCountersTest) {
+
+  // Counts added by several threads are summed per slot, whether or not
+  // the kernel counts for this process
+  std::string error;
+  bool started = StartPerfCounters(2, error);
+  EXPECT_EQ(started, error.empty());
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.push_back(std::thread([i]() {
+      PerfCounts start, end;
+      end.values[PERF_COUNTER_INSTRUCTIONS] = 10 * (i + 1);
+      AddPerfCounts(i % 2, start, end);
+      AddPerfCounts(1, start, end, 0);
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<PerfCounts> slot_counts;
+  bool available[PERF_COUNTER_COUNT];
+  StopPerfCounters(slot_counts, available);
+  EXPECT_FALSE(perf_counters_enabled);
+  ASSERT_EQ(slot_counts.size(), 2u);
+  EXPECT_EQ(slot_counts[0].values[PERF_COUNTER_INSTRUCTIONS], 40u);
+  EXPECT_EQ(slot_counts[0].sample_count, 2u);
+  EXPECT_EQ(slot_counts[1].values[PERF_COUNTER_INSTRUCTIONS], 160u);
+  EXPECT_EQ(slot_counts[1].sample_count, 2u);
+  EXPECT_EQ(available[PERF_COUNTER_TASK_CLOCK], started);
+
+  // Reported after the summary when the counters are available
+  Configuration default_conf;
+  default_conf.testing_mode = true;
+  default_conf.perf_counters_mode = true;
+  default_conf.test_stream.reset(new std::istringstream("SELECT * FROM a;"));
+
+  testing::internal::CaptureStdout();
+  testing::internal::CaptureStderr();
+  Check(default_conf);
+  auto output = testing::internal::GetCapturedStdout();
+  auto errors = testing::internal::GetCapturedStderr();
+
+  if (started == true) {
+    EXPECT_NE(output.find("Statements :: 2"), std::string::npos);
+    EXPECT_NE(output.find("Finding Cache :: 0 hits, 2 misses"), std::string::npos);
+    EXPECT_NE(output.find("> SelectStar"), std::string::npos);
+  }
+  else {
+    EXPECT_EQ(output.find("Performance Counters"), std::string::npos);
+    EXPECT_NE(errors.find("Performance counters unavailable"), std::string::npos);
+  }
+
+}
+
+TEST(TestSuite, LiteralListTest) {
+
+  // Long lists and runs of tuples keep their first item
+  LineShifts line_shifts;
+  std::string statement = "select * from t where id in (1, 2, 3)";
+  CollapseLiteralLists(statement, line_shifts);
+  EXPECT_EQ(statement, "select * from t where id in (1, 2, 3)");
+  EXPECT_TRUE(line_shifts.empty());
+
+  std::string list = "select * from t where id in (";
+  std::string tuples = "insert into t values ";
+  for (int i = 0; i < 1000; i++) {
+    list += (i == 0 ? "" : ", ") + std::to_string(i);
+    tuples += (i == 0 ? "(" : ",\n(") + std::to_string(-i) + ", 'a''b', null)";
+  }
+  list += ") and name = 'x, (1, 2)'";
+  CollapseLiteralLists(list, line_shifts);
+  EXPECT_EQ(list, "select * from t where id in (0, ?) and name = 'x, (1, 2)'");
+  EXPECT_TRUE(line_shifts.empty());
+  CollapseLiteralLists(tuples, line_shifts);
+  EXPECT_EQ(tuples, "insert into t values (0, 'a''b', null), (?, null)");
+  ASSERT_EQ(line_shifts.size(), 1u);
+  EXPECT_EQ(line_shifts[0].lines, 999u);
+  EXPECT_EQ(GetRemovedLines(line_shifts, 0), 0u);
+  EXPECT_EQ(GetRemovedLines(line_shifts, tuples.size()), 999u);
+
+  // Lists of expressions and lists in strings are kept
+  std::string expressions = "select * from t where id in (a, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, "
+      "11, 12, 13, 14, 15, 16) and b = '(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16)'";
+  auto kept = expressions;
+  CollapseLiteralLists(expressions, line_shifts);
+  EXPECT_EQ(expressions, kept);
+
+  // NULLs of the removed literals are still seen by the NULL Usage rule
+  std::string null_list = "select * from t where a in (1, 1, 1, 1, 1, null";
+  std::string null_tuples = "insert into t values (1, 'x')";
+  for (int i = 2; i <= 21; i++) {
+    null_list += (i < 7) ? "" : ", " + std::to_string(i);
+    null_tuples += (i == 6) ? ", (null, 'y')" : ", (" + std::to_string(i) + ", 'x')";
+  }
+  null_list += ")";
+  for (auto* text : {&null_list, &null_tuples}) {
+    Configuration default_conf;
+    CollectFindings(default_conf, NormalizeStatement(default_conf, *text));
+    bool null_usage = false;
+    for (const auto& finding : default_conf.findings) {
+      null_usage |= (GetRules()[finding.rule].name == std::string("NullUsage"));
+    }
+    EXPECT_TRUE(null_usage) << *text;
+  }
+  CollapseLiteralLists(null_list, line_shifts);
+  EXPECT_EQ(null_list, "select * from t where a in (1, ?, null)");
+  CollapseLiteralLists(null_tuples, line_shifts);
+  EXPECT_EQ(null_tuples, "insert into t values (1, 'x'), (?, null)");
+
+  // Lists whose removed literals match another pattern are kept
+  std::string float_list = "select a from t where x in (1, 1, 1, 1, 1, 0.0001";
+  std::string password_tuples = "insert into t values (1, 'x')";
+  for (int i = 7; i <= 26; i++) {
+    float_list += ", " + std::to_string(i);
+    password_tuples += (i == 9) ? ", (9, 'password = x')" : ", (" + std::to_string(i) + ", 'x')";
+  }
+  float_list += ")";
+  const std::pair<std::string*, const char*> kept_lists[] = {
+    {&float_list, "Float"}, {&password_tuples, "ReadablePasswords"}
+  };
+  for (const auto& kept_list : kept_lists) {
+    Configuration default_conf;
+    auto normalized = NormalizeStatement(default_conf, *kept_list.first);
+    EXPECT_EQ(normalized, *kept_list.first);
+    CollectFindings(default_conf, normalized);
+    bool found = false;
+    for (const auto& finding : default_conf.findings) {
+      found |= (GetRules()[finding.rule].name == std::string(kept_list.second));
+    }
+    EXPECT_TRUE(found) << *kept_list.first;
+  }
+
+  // Normalization collapses the spaces the way it did with a regex, and
+  // keeps the case
+  static const std::regex space_pattern("^ +| +$|( ) +");
+  const char characters[] = {' ', ' ', '\n', '\t', 'A', 'b'};
+  srand(1);
+  for (int i = 0; i < 1000; i++) {
+    std::string text(rand() % 12, ' ');
+    for (auto& c : text) {
+      c = characters[rand() % sizeof(characters)];
+    }
+    if (text.empty()) {
+      continue;
+    }
+    Configuration default_conf;
+    auto expected = std::regex_replace(text, space_pattern, "$1");
+    if (expected[0] == '\n') {
+      expected.erase(0, 1);
+    }
+    EXPECT_EQ(NormalizeStatement(default_conf, text), expected) << text;
+  }
+
+  // Findings after a collapsed list are reported at their own lines
+  std::string input = "SELECT 1;\nSELECT id FROM t WHERE id IN (\n";
+  for (int i = 0; i < 2000; i++) {
+    input += std::to_string(i) + ",\n";
+  }
+  input += "0)\nUNION SELECT * FROM u;\nSELECT * FROM u;\n";
+
+  for (size_t thread_count = 1; thread_count <= 2; thread_count++) {
+    Configuration default_conf;
+    default_conf.testing_mode = true;
+    default_conf.color_mode = false;
+    default_conf.line_width = 0;
+    default_conf.thread_count = thread_count;
+    default_conf.test_stream.reset(new std::istringstream(input));
+
+    testing::internal::CaptureStdout();
+    Check(default_conf);
+    auto output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(output.find("SQL Statement at line 2: SELECT id FROM t WHERE id IN (\n0, ?)\n"
+                          "UNION SELECT * FROM u;"), std::string::npos) << thread_count;
+    EXPECT_NE(output.find("SELECT * at line 2004]"), std::string::npos) << thread_count;
+    EXPECT_NE(output.find("SQL Statement at line 2005: SELECT * FROM u;"), std::string::npos)
+        << thread_count;
+  }
+
+}
+
+TEST(TestSuite, LexerTest) {
+
+  // Each keyword finds itself in the perfect hash, other words find none
+  for (size_t keyword = 1; keyword < kKeywordCount; keyword++) {
+    std::string name = GetKeywordName(static_cast<Keyword>(keyword));
+    EXPECT_EQ(LookupKeyword(name.data(), name.size()), keyword) << name;
+    auto prefix = name.substr(0, name.size() - 1);
+    EXPECT_NE(LookupKeyword(prefix.data(), prefix.size()), keyword) << name;
+  }
+  EXPECT_EQ(LookupKeyword("selects", 7), KEYWORD_NONE);
+  EXPECT_EQ(LookupKeyword("users", 5), KEYWORD_NONE);
+  EXPECT_EQ(LookupKeyword("x", 1), KEYWORD_NONE);
+  EXPECT_EQ(LookupKeyword("SELECT", 6), KEYWORD_SELECT);
+  EXPECT_EQ(LookupKeyword("Auto_Increment", 14), KEYWORD_AUTO_INCREMENT);
+  EXPECT_EQ(LookupKeyword("SELECTS", 7), KEYWORD_NONE);
+
+  // Strings, quoted identifiers, comments and numbers are skipped
+  std::vector<Keyword> keywords;
+  KeywordSet keyword_set;
+  LexKeywords("select id, 'from t' from \"order\" -- where\n"
+              "where id in (1e5, 2) /* union */ and name_or like 'a''or'", keywords,
+              keyword_set);
+  std::vector<Keyword> expected = {
+    KEYWORD_SELECT, KEYWORD_FROM, KEYWORD_WHERE, KEYWORD_IN, KEYWORD_AND, KEYWORD_LIKE
+  };
+  EXPECT_EQ(keywords, expected);
+
+  LexKeywords("insert into t values ('unterminated", keywords, keyword_set);
+  expected = {KEYWORD_INSERT, KEYWORD_INTO, KEYWORD_VALUES};
+  EXPECT_EQ(keywords, expected);
+
+}
+
+TEST(TestSuite, StatementKindTest) {
+
+  std::vector<std::pair<std::string, StatementKind>> statements = {
+    {"select * from t;", STATEMENT_KIND_SELECT},
+    {"with a as (select 1) select * from a;", STATEMENT_KIND_SELECT},
+    {"-- create table t\ninsert into t values (1);", STATEMENT_KIND_INSERT},
+    {"update t set a = 1;", STATEMENT_KIND_UPDATE},
+    {"delete from t;", STATEMENT_KIND_DELETE},
+    {"create temporary table t (id int);", STATEMENT_KIND_CREATE_TABLE},
+    {"create table t as select * from u;", STATEMENT_KIND_CREATE_TABLE_AS_SELECT},
+    {"alter table t add column a int;", STATEMENT_KIND_ALTER_TABLE},
+    {"create unique index i on t (a);", STATEMENT_KIND_CREATE_INDEX},
+    {"create or replace view v as select * from t;", STATEMENT_KIND_CREATE_OTHER},
+    {"drop table t;", STATEMENT_KIND_OTHER},
+    {"", STATEMENT_KIND_OTHER}
+  };
+  std::vector<Keyword> keywords;
+  KeywordSet keyword_set;
+  for (const auto& statement : statements) {
+    LexKeywords(statement.first, keywords, keyword_set);
+    EXPECT_EQ(ClassifyStatement(keywords), statement.second) << statement.first;
+  }
+
+  // Rules of table definitions do not run on queries, and rules of queries
+  // do not run on table definitions
+  const auto& rules = GetRules();
+  auto has_rule = [&rules](const StatementKind kind, const std::string& name) {
+    for (auto rule : GetStatementRules(kind)) {
+      if (rules[rule].name == name) {
+        return true;
+      }
+    }
+    return false;
+  };
+  EXPECT_FALSE(has_rule(STATEMENT_KIND_SELECT, "PrimaryKeyExists"));
+  EXPECT_TRUE(has_rule(STATEMENT_KIND_CREATE_TABLE, "PrimaryKeyExists"));
+  EXPECT_TRUE(has_rule(STATEMENT_KIND_CREATE_TABLE_AS_SELECT, "PrimaryKeyExists"));
+  EXPECT_FALSE(has_rule(STATEMENT_KIND_CREATE_TABLE, "Union"));
+  EXPECT_TRUE(has_rule(STATEMENT_KIND_CREATE_TABLE_AS_SELECT, "Union"));
+  EXPECT_TRUE(has_rule(STATEMENT_KIND_CREATE_TABLE, "NullUsage"));
+  EXPECT_TRUE(has_rule(STATEMENT_KIND_SELECT, "NullUsage"));
+
+  Configuration default_conf;
+  CollectFindings(default_conf, "create table reunion (id int);");
+  std::set<size_t> rule_findings;
+  for (const auto& finding : default_conf.findings) {
+    rule_findings.insert(finding.rule);
+  }
+  EXPECT_EQ(default_conf.statement_kind, STATEMENT_KIND_CREATE_TABLE);
+  EXPECT_EQ(rule_findings.size(), 1u);
+  EXPECT_EQ(rules[*rule_findings.begin()].name, std::string("GenericPrimaryKey"));
+
+  CollectFindings(default_conf, "select * from t where id in (select id from u) union "
+                  "select * from v;");
+  EXPECT_EQ(default_conf.statement_kind, STATEMENT_KIND_SELECT);
+  EXPECT_FALSE(default_conf.findings.empty());
+  for (const auto& finding : default_conf.findings) {
+    EXPECT_TRUE(rules[finding.rule].kinds & kQueryKinds) << rules[finding.rule].name;
+  }
+
+}
+
+TEST(TestSuite, KeywordGatingTest) {
+
+  KeywordSet keyword_set;
+  std::vector<Keyword> keywords;
+  LexKeywords("select distinct a from t join u on t.a = u.a -- group by", keywords,
+              keyword_set);
+  EXPECT_TRUE(keyword_set.Contains(KEYWORD_JOIN));
+  EXPECT_TRUE(keyword_set.Contains(KEYWORD_WITH) == false);
+  EXPECT_TRUE(keyword_set.ContainsAll({KEYWORD_DISTINCT, KEYWORD_JOIN}));
+  EXPECT_FALSE(keyword_set.ContainsAll({KEYWORD_HAVING, KEYWORD_JOIN}));
+  EXPECT_TRUE(keyword_set.ContainsAll(KeywordSet()));
+
+  // The set also has the keywords of comments and strings, but not the
+  // keywords ending or starting other words
+  EXPECT_TRUE(keyword_set.ContainsAll({KEYWORD_GROUP, KEYWORD_BY}));
+  EXPECT_EQ(std::count(keywords.begin(), keywords.end(), KEYWORD_GROUP), 0);
+  LexKeywords("select ifnull(a, 'or') from reunion /* having */", keywords, keyword_set);
+  EXPECT_TRUE(keyword_set.ContainsAll({KEYWORD_OR, KEYWORD_HAVING}));
+  EXPECT_FALSE(keyword_set.Contains(KEYWORD_NULL));
+  EXPECT_FALSE(keyword_set.Contains(KEYWORD_UNION));
+
+  // Keywords past the first word of the set
+  KeywordSet last_keywords = {KEYWORD_WITH, KEYWORD_WINDOW};
+  EXPECT_FALSE(keyword_set.ContainsAll(last_keywords));
+  keyword_set.Add(KEYWORD_WITH);
+  keyword_set.Add(KEYWORD_WINDOW);
+  EXPECT_TRUE(keyword_set.ContainsAll(last_keywords));
+
+  // Rules run only when the statement has their keywords
+  const auto& rules = GetRules();
+  auto find_rule = [&rules](const Configuration& state, const std::string& name) {
+    for (const auto& finding : state.findings) {
+      if (rules[finding.rule].name == name) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  Configuration default_conf;
+  CollectFindings(default_conf, "select a from t order by rand();");
+  EXPECT_TRUE(find_rule(default_conf, "OrderByRand"));
+  CollectFindings(default_conf, "select a from t; -- order by rand()");
+  EXPECT_TRUE(find_rule(default_conf, "OrderByRand"));
+  CollectFindings(default_conf, "select a from t order by random();");
+  EXPECT_FALSE(find_rule(default_conf, "OrderByRand"));
+
+  // Patterns matching inside words have no keywords
+  CollectFindings(default_conf, "select ifnull(a, 0) from t;");
+  EXPECT_TRUE(find_rule(default_conf, "NullUsage"));
+  CollectFindings(default_conf, "select a from reunion;");
+  EXPECT_TRUE(find_rule(default_conf, "Union"));
+  CollectFindings(default_conf, "select a, count(*) from t subgroup by a;");
+  EXPECT_TRUE(find_rule(default_conf, "GroupByUsage"));
+  CollectFindings(default_conf,
+                  "create table t (index_a int, index_b int, index_c int, index_d int);");
+  EXPECT_TRUE(find_rule(default_conf, "IndexCount"));
+
+}
+
+TEST(TestSuite, CaseInsensitiveTest) {
+
+  EXPECT_EQ(FoldPatternCase("(group by)"), "([gG][rR][oO][uU][pP] [bB][yY])");
+  EXPECT_EQ(FoldPatternCase("in\\s+\\("), "[iI][nN]\\s+\\(");
+  EXPECT_EQ(FoldPatternCase("[a-z0-9_]+x"), "[a-zA-Z0-9_]+[xX]");
+  EXPECT_EQ(FoldPatternCase("[^=]"), "[^=]");
+
+  // Statements are matched in any case, and reported in their own
+  std::vector<std::string> statements = {
+    "SELECT DISTINCT a FROM t JOIN u ON t.a = u.a GROUP BY a ORDER BY RAND();",
+    "CREATE TABLE Node_Attribute (ID VARCHAR(10), Parent INT REFERENCES NODE_ATTRIBUTE, "
+        "Price FLOAT NOT NULL, Password TEXT);",
+    "Insert Into t Values (1, NULL) UNION select * from u;"
+  };
+  const auto& rules = GetRules();
+  for (const auto& statement : statements) {
+    auto lower_statement = statement;
+    std::transform(lower_statement.begin(), lower_statement.end(), lower_statement.begin(),
+                   ::tolower);
+
+    Configuration default_conf;
+    CollectFindings(default_conf, lower_statement);
+    auto lower_findings = default_conf.findings;
+    auto normalized_statement = NormalizeStatement(default_conf, statement);
+    EXPECT_EQ(normalized_statement, statement);
+    CollectFindings(default_conf, normalized_statement);
+
+    EXPECT_FALSE(lower_findings.empty());
+    ASSERT_EQ(default_conf.findings.size(), lower_findings.size()) << statement;
+    for (size_t i = 0; i < lower_findings.size(); i++) {
+      const auto& finding = default_conf.findings[i];
+      EXPECT_EQ(finding.rule, lower_findings[i].rule) << rules[finding.rule].name;
+      EXPECT_EQ(finding.lines, lower_findings[i].lines) << rules[finding.rule].name;
+      auto lower_match = finding.match;
+      std::transform(lower_match.begin(), lower_match.end(), lower_match.begin(), ::tolower);
+      EXPECT_EQ(lower_match, lower_findings[i].match);
+      EXPECT_NE(statement.find(finding.match), std::string::npos) << finding.match;
+    }
+  }
+
+  Configuration default_conf;
+  CollectFindings(default_conf, statements[1]);
+  EXPECT_EQ(GetInterner().GetString(default_conf.table_name), "node_attribute");
+
+}
+
+TEST(TestSuite, InternerTest) {
+
+  EXPECT_EQ(HashString("users", 5), HashString(std::string("users").data(), 5));
+  EXPECT_NE(HashString("users", 5), HashString("user", 4));
+
+  // Equal names get equal ids, dense from 1
+  StringInterner interner;
+  EXPECT_EQ(interner.Intern(""), kNoStringId);
+  auto users = interner.Intern("users");
+  EXPECT_EQ(users, 1u);
+  EXPECT_EQ(interner.Intern("orders"), 2u);
+  EXPECT_EQ(interner.Intern(std::string("users")), users);
+  EXPECT_EQ(interner.Find("users"), users);
+  EXPECT_EQ(interner.Find("items"), kNoStringId);
+  EXPECT_STREQ(interner.GetData(users), "users");
+  EXPECT_EQ(interner.GetSize(users), 5u);
+
+  // Many names, from several threads, long ones included
+  std::vector<std::thread> threads;
+  std::vector<std::vector<StringId>> thread_ids(4);
+  for (size_t i = 0; i < thread_ids.size(); i++) {
+    threads.push_back(std::thread([&interner, &thread_ids, i]() {
+      for (int table = 0; table < 5000; table++) {
+        auto name = "table_" + std::to_string(table);
+        if (table % 1000 == 0) {
+          name += std::string(100000, 'x');
+        }
+        thread_ids[i].push_back(interner.Intern(name));
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(interner.GetCount(), 5002u);
+  for (size_t i = 1; i < thread_ids.size(); i++) {
+    EXPECT_EQ(thread_ids[i], thread_ids[0]);
+  }
+  EXPECT_EQ(interner.GetString(thread_ids[0][42]), "table_42");
+  EXPECT_EQ(interner.GetSize(thread_ids[0][1000]), 100010u);
+  EXPECT_EQ(interner.GetString(users), "users");
+
+  interner.Clear();
+  EXPECT_EQ(interner.GetCount(), 0u);
+  EXPECT_EQ(interner.Find("users"), kNoStringId);
+
+  // Rules see the table created by the statement
+  Configuration default_conf;
+  default_conf.table_name = GetTableId("create table node_attribute (id int);");
+  EXPECT_EQ(GetInterner().GetString(default_conf.table_name), "node_attribute");
+  EXPECT_EQ(GetTableId("create table node_attribute(id int);"), default_conf.table_name);
+  EXPECT_EQ(GetTableId("select * from node_attribute;"), kNoStringId);
+
+  bool print_statement = true;
+  CheckVariableAttribute(default_conf, "create table node_attribute (id int);",
+                         print_statement);
+  ASSERT_EQ(default_conf.findings.size(), 1u);
+  EXPECT_EQ(default_conf.findings[0].title, "Entity-Attribute-Value Pattern");
+
+}
+
+TEST(TestSuite, MatcherTest) {
+
+  EXPECT_STREQ(GetPatternName(PATTERN_SELECT_STAR), "SELECT_STAR");
+  EXPECT_STREQ(GetPatternText(PATTERN_SELECT_STAR), "(select\\s+\\*)");
+  EXPECT_TRUE(MatchPattern(PATTERN_SELECT_STAR, "SELECT\n\t* FROM t", 15));
+  EXPECT_FALSE(MatchPattern(PATTERN_SELECT_STAR, "SELECT a FROM t", 15));
+  EXPECT_FALSE(MatchPattern(PATTERN_SELECT_STAR, "", 0));
+
+  // The generated state machines match the texts their regexes match, on
+  // random texts made of pieces of the patterns
+  std::vector<std::string> pieces = {
+    " ", "\t", "\n", "\r", "\b", "\xe9", "*", "=", "(", ",", ".", "_", "-", "@", "|",
+    "||", "0", "1", "0.000", "a", "x", "id", "ID", "Id", "select", "SELECT", "Select *",
+    "join", "JOIN",
+    "left", "where", "case", "distinct", "null", "NOT", "not null", "varchar", "text",
+    "regexp", "serial", "primary key", "foreign key", "attribute", "float", "real",
+    "double precision", "enum", " in (", "path", "unlink", "index", "create index",
+    "group by", "order by rand(", "like", "similar to", "insert into t", "values",
+    " VALUES", "having", "or", "union", "password", "pwd =", "pattern must not exist"
+  };
+  std::minstd_rand random(42);
+  for (size_t pattern = 0; pattern < kPatternCount; pattern++) {
+    auto id = static_cast<PatternId>(pattern);
+    std::regex regex(FoldPatternCase(GetPatternText(id)));
+    size_t match_count = 0;
+    for (int text_index = 0; text_index < 2000; text_index++) {
+      std::string text;
+      auto piece_count = random() % 12;
+      for (size_t piece = 0; piece < piece_count; piece++) {
+        text += pieces[random() % pieces.size()];
+      }
+      auto matches = std::regex_search(text, regex);
+      ASSERT_EQ(MatchPattern(id, text.data(), text.size()), matches)
+          << GetPatternName(id) << ": " << text;
+      match_count += matches;
+    }
+    if (id != PATTERN_PATTERN_MATCHING && id != PATTERN_JOIN_COUNT &&
+        id != PATTERN_DISTINCT_COUNT && id != PATTERN_HAVING && id != PATTERN_NESTING &&
+        id != PATTERN_OR) {
+      EXPECT_GT(match_count, 0u) << GetPatternName(id);
+    }
+  }
+
+  // Other patterns run their regex only
+  Matcher references("(references\\s+users)", std::regex::icase);
+  EXPECT_TRUE(references.MayMatch("SELECT 1"));
+  EXPECT_TRUE(std::regex_search("REFERENCES  Users", references.GetRegex()));
+  Matcher select_star(PATTERN_SELECT_STAR);
+  EXPECT_FALSE(select_star.MayMatch("SELECT 1"));
+  EXPECT_TRUE(std::regex_search("Select *", select_star.GetRegex()));
+
+}
+
+TEST(TestSuite, PatternScanTest) {
+
+  // Whichever the backend, a scan never rules out a pattern with a match
+  std::vector<std::string> statements = {
+    "",
+    "SELECT * FROM t WHERE a IS NULL;",
+    "CREATE TABLE t (id INT PRIMARY KEY, password VARCHAR(20), x FLOAT);",
+    "INSERT INTO t VALUES (1, 0.0001);",
+    "SELECT DISTINCT a FROM t1 JOIN t2 ON t1.a > t2.a WHERE b || c GROUP BY a ORDER BY RAND();"
+  };
+  for (const auto& statement : statements) {
+    auto candidates = ScanPatterns(statement);
+    for (size_t pattern = 0; pattern < kPatternCount; pattern++) {
+      auto id = static_cast<PatternId>(pattern);
+      if (MatchPattern(id, statement.data(), statement.size())) {
+        EXPECT_NE(candidates & GetPatternBit(id), 0u) << GetPatternName(id) << ": " << statement;
+      }
+    }
+  }
+
+  Configuration default_conf;
+  AnalyzeStatement(default_conf, "SELECT * FROM t;");
+  EXPECT_NE(default_conf.pattern_matches & GetPatternBit(PATTERN_SELECT_STAR), 0u);
+
+  // Rules skip the patterns ruled out
+  bool print_statement = true;
+  default_conf.pattern_matches = kAllPatterns & ~GetPatternBit(PATTERN_SELECT_STAR);
+  CheckSelectStar(default_conf, "SELECT * FROM t;", print_statement);
+  EXPECT_TRUE(default_conf.findings.empty());
+  default_conf.pattern_matches = kAllPatterns;
+  CheckSelectStar(default_conf, "SELECT * FROM t;", print_statement);
+  EXPECT_EQ(default_conf.findings.size(), 1u);
+
+}
+
+TEST(TestSuite, StatsTest) {
+
+  auto summary = SummarizeSamples({5, 1, 4, 2, 3, 100, 3, 3, 2, 4});
+  EXPECT_EQ(summary.count, 10u);
+  EXPECT_DOUBLE_EQ(summary.median, 3);
+  EXPECT_DOUBLE_EQ(summary.mad, 1);
+  EXPECT_DOUBLE_EQ(summary.ci_low, 1);
+  EXPECT_DOUBLE_EQ(summary.ci_high, 5);
+
+  // A slowdown is a regression only beyond the threshold and the noise
+  std::vector<double> baseline, noisy, slower;
+  double noisy_samples[5] = {50, 90, 110, 130, 170};
+  for (int i = 0; i < 20; i++) {
+    baseline.push_back(100 + i % 5);
+    noisy.push_back(noisy_samples[i % 5]);
+    slower.push_back(120 + i % 5);
+  }
+  EXPECT_EQ(CompareSamples(baseline, baseline, 0.05).result, COMPARISON_UNCHANGED);
+  EXPECT_EQ(CompareSamples(baseline, noisy, 0.05).result, COMPARISON_UNCHANGED);
+  auto comparison = CompareSamples(baseline, slower, 0.05);
+  EXPECT_EQ(comparison.result, COMPARISON_SLOWER);
+  EXPECT_NEAR(comparison.change, 0.196, 0.001);
+  EXPECT_EQ(CompareSamples(baseline, slower, 0.25).result, COMPARISON_UNCHANGED);
+  EXPECT_EQ(CompareSamples(slower, baseline, 0.05).result, COMPARISON_FASTER);
+
+}
+
 }  // End machine sqlcheck